@@ -0,0 +1,482 @@
+#include "AssetArchive.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const std::string AssetArchive::archiveFile = "assets.pak";
+const std::vector<std::string> AssetArchive::packedFiles =
+{
+	"font/arial.ttf", "font/aAbsoluteEmpire.ttf", "font/retro.ttf", "font/Run.otf",
+	"gfx/atlas.png", "gfx/atlas.txt", "gfx/football.png", "gfx/goalposts.png", "gfx/icon.png", "gfx/kirby.png", "gfx/messi.png", "gfx/miedema.png", "gfx/ronaldo.png", "gfx/Samson.png",
+	"levels/arena.txt"
+};
+
+// Start of every archive, and the version of the layout.
+static const char magic[4] = { 'C', 'M', 'P', 'K' };
+static const std::uint32_t version = 1;
+
+// Functions for reading and writing little endian numbers, so archives are the same on every machine.
+// ----
+static std::uint64_t readNumber(const char* data, int bytes)
+{
+	std::uint64_t number = 0;
+	for (int i = bytes - 1; i >= 0; i--)
+	{
+		number = (number << 8) | (unsigned char)data[i];
+	}
+	return number;
+}
+
+static void writeNumber(std::vector<char>& data, std::uint64_t number, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+	{
+		data.push_back(char(number >> (i * 8)));
+	}
+}
+// ----
+
+AssetArchive::AssetArchive()
+{
+	data = nullptr;
+	size = 0;
+}
+
+AssetArchive::AssetArchive(std::string filename)
+{
+	data = nullptr;
+	size = 0;
+	open(filename);
+}
+
+AssetArchive::~AssetArchive()
+{
+	close();
+}
+
+AssetArchive& AssetArchive::getShared()
+{
+	// Opened once, the first time any asset is loaded. If there isn't an archive every asset is loaded from its loose file.
+	static AssetArchive archive(archiveFile);
+	return archive;
+}
+
+bool AssetArchive::open(std::string filename)
+{
+	close();
+
+	// Map the whole file. The handles can be closed straight away, as the mapping keeps the file open until it is unmapped.
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+	{
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	}
+	if (mapping)
+	{
+		data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		size = std::size_t(fileSize.QuadPart);
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+#else
+	int file = ::open(filename.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+	struct stat status;
+	if (fstat(file, &status) == 0 && status.st_size > 0)
+	{
+		void* mapped = mmap(nullptr, std::size_t(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapped != MAP_FAILED)
+		{
+			data = (const char*)mapped;
+			size = std::size_t(status.st_size);
+		}
+	}
+	::close(file);
+#endif
+
+	if (!data)
+	{
+		std::cout << "Could not map asset archive " << filename << ".\n";
+		return false;
+	}
+
+	// The header is the magic, version and number of files, then each file's name length, name, offset, size and stored size.
+	if (size < 12 || std::memcmp(data, magic, 4) != 0 || readNumber(data + 4, 4) != version)
+	{
+		std::cout << filename << " is not an asset archive.\n";
+		close();
+		return false;
+	}
+
+	std::size_t count = std::size_t(readNumber(data + 8, 4));
+	std::size_t position = 12;
+	for (std::size_t i = 0; i < count; i++)
+	{
+		std::size_t nameLength = position + 2 <= size ? std::size_t(readNumber(data + position, 2)) : size;
+		if (position + 2 + nameLength + 24 > size)
+		{
+			std::cout << "Asset archive " << filename << " is damaged.\n";
+			close();
+			return false;
+		}
+		std::string name(data + position + 2, nameLength);
+		position += 2 + nameLength;
+
+		Entry entry;
+		entry.offset = std::size_t(readNumber(data + position, 8));
+		entry.size = std::size_t(readNumber(data + position + 8, 8));
+		entry.storedSize = std::size_t(readNumber(data + position + 16, 8));
+		position += 24;
+
+		if (entry.offset > size || entry.storedSize > size - entry.offset)
+		{
+			std::cout << "Asset archive " << filename << " is damaged.\n";
+			close();
+			return false;
+		}
+		entries[name] = entry;
+	}
+
+	std::cout << "Loaded " << entries.size() << " assets from " << filename << ".\n";
+	return true;
+}
+
+void AssetArchive::close()
+{
+	if (data)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap((void*)data, size);
+#endif
+	}
+
+	data = nullptr;
+	size = 0;
+	entries.clear();
+	decompressed.clear();
+}
+
+bool AssetArchive::pack(std::string filename, const std::vector<std::string>& files)
+{
+	// Read every file, keeping the compressed copy if it is smaller.
+	std::vector<std::string> names;
+	std::vector<std::vector<char>> contents;
+	std::vector<std::size_t> sizes;
+	std::size_t total = 0;
+	for (int i = 0; i < files.size(); i++)
+	{
+		std::ifstream file(files[i], std::ios::binary);
+		if (!file)
+		{
+			std::cout << "Skipping missing asset " << files[i] << ".\n";
+			continue;
+		}
+		std::vector<char> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		std::vector<char> compressed = compress(content.data(), content.size());
+
+		names.push_back(files[i]);
+		sizes.push_back(content.size());
+		contents.push_back(compressed.size() < content.size() ? compressed : content);
+		total += content.size();
+	}
+
+	// Work out where the files start, after the directory.
+	std::size_t offset = 12;
+	for (int i = 0; i < names.size(); i++)
+	{
+		offset += 2 + names[i].size() + 24;
+	}
+
+	std::vector<char> archive(magic, magic + 4);
+	writeNumber(archive, version, 4);
+	writeNumber(archive, names.size(), 4);
+	for (int i = 0; i < names.size(); i++)
+	{
+		writeNumber(archive, names[i].size(), 2);
+		archive.insert(archive.end(), names[i].begin(), names[i].end());
+		writeNumber(archive, offset, 8);
+		writeNumber(archive, sizes[i], 8);
+		writeNumber(archive, contents[i].size(), 8);
+		offset += contents[i].size();
+	}
+	for (int i = 0; i < contents.size(); i++)
+	{
+		archive.insert(archive.end(), contents[i].begin(), contents[i].end());
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file || !file.write(archive.data(), archive.size()))
+	{
+		std::cout << "Could not save asset archive " << filename << ".\n";
+		return false;
+	}
+
+	std::cout << "Packed " << names.size() << " assets (" << total << " bytes) into " << archive.size() << " byte archive " << filename << ".\n";
+	return true;
+}
+
+bool AssetArchive::getData(std::string filename, const char*& fileData, std::size_t& fileSize)
+{
+	std::map<std::string, Entry>::iterator it = entries.find(filename);
+	if (it == entries.end())
+	{
+		return false;
+	}
+
+	// Stored files are read straight from the mapping.
+	const Entry& entry = it->second;
+	if (entry.storedSize == entry.size)
+	{
+		fileData = data + entry.offset;
+		fileSize = entry.size;
+		return true;
+	}
+
+	// Compressed files are decompressed once and kept, as fonts keep reading the memory they were loaded from.
+	std::lock_guard<std::mutex> lock(mutex);
+	std::map<std::string, std::vector<char>>::iterator copy = decompressed.find(filename);
+	if (copy == decompressed.end())
+	{
+		std::vector<char> contents(entry.size);
+		if (!decompress(data + entry.offset, entry.storedSize, contents.data(), contents.size()))
+		{
+			std::cout << "Could not decompress " << filename << " from the asset archive.\n";
+			return false;
+		}
+		copy = decompressed.insert(std::make_pair(filename, contents)).first;
+	}
+
+	fileData = copy->second.data();
+	fileSize = copy->second.size();
+	return true;
+}
+
+bool AssetArchive::loadImage(sf::Image& image, std::string filename)
+{
+	const char* fileData;
+	std::size_t fileSize;
+	if (getData(filename, fileData, fileSize))
+	{
+		return image.loadFromMemory(fileData, fileSize);
+	}
+	return image.loadFromFile(filename);
+}
+
+bool AssetArchive::loadTexture(sf::Texture& texture, std::string filename)
+{
+	const char* fileData;
+	std::size_t fileSize;
+	if (getData(filename, fileData, fileSize))
+	{
+		return texture.loadFromMemory(fileData, fileSize);
+	}
+	return texture.loadFromFile(filename);
+}
+
+bool AssetArchive::loadFont(sf::Font& font, std::string filename)
+{
+	const char* fileData;
+	std::size_t fileSize;
+	if (getData(filename, fileData, fileSize))
+	{
+		return font.loadFromMemory(fileData, fileSize);
+	}
+	return font.loadFromFile(filename);
+}
+
+bool AssetArchive::loadText(std::string& text, std::string filename)
+{
+	const char* fileData;
+	std::size_t fileSize;
+	if (getData(filename, fileData, fileSize))
+	{
+		text.assign(fileData, fileSize);
+		return true;
+	}
+
+	std::ifstream file(filename, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	text.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return true;
+}
+
+std::size_t AssetArchive::getFileSize(std::string filename)
+{
+	std::map<std::string, Entry>::iterator it = entries.find(filename);
+	if (it != entries.end())
+	{
+		return it->second.size;
+	}
+
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	return file ? std::size_t(file.tellg()) : 0;
+}
+
+// Write the part of a literal or match length that doesn't fit in the token, as bytes of 255 followed by the rest.
+static void writeLength(std::vector<char>& output, std::size_t length)
+{
+	while (length >= 255)
+	{
+		output.push_back(char(255));
+		length -= 255;
+	}
+	output.push_back(char(length));
+}
+
+std::vector<char> AssetArchive::compress(const char* source, std::size_t sourceSize)
+{
+	// Greedy LZ4: look up the last place each four bytes were seen in a hash table, and copy from there if they match.
+	// Each sequence is a token (literal length and match length - 4, four bits each, with 15 meaning more bytes follow), the literals, then a two byte offset back to the match.
+	// The format needs the last five bytes to be literals, and no match to start in the last twelve.
+	std::vector<char> output;
+	std::vector<int> table(4096, -1);
+	std::size_t anchor = 0;
+	std::size_t i = 0;
+	std::size_t matchLimit = sourceSize > 12 ? sourceSize - 12 : 0;
+
+	while (i < matchLimit)
+	{
+		std::uint32_t sequence;
+		std::memcpy(&sequence, source + i, 4);
+		std::uint32_t hash = (sequence * 2654435761u) >> 20;
+		int candidate = table[hash];
+		table[hash] = int(i);
+
+		if (candidate < 0 || i - candidate > 65535 || std::memcmp(source + candidate, source + i, 4) != 0)
+		{
+			i++;
+			continue;
+		}
+
+		std::size_t length = 4;
+		while (i + length < sourceSize - 5 && source[candidate + length] == source[i + length])
+		{
+			length++;
+		}
+
+		std::size_t literals = i - anchor;
+		output.push_back(char((std::min<std::size_t>(literals, 15) << 4) | std::min<std::size_t>(length - 4, 15)));
+		if (literals >= 15)
+		{
+			writeLength(output, literals - 15);
+		}
+		output.insert(output.end(), source + anchor, source + i);
+		writeNumber(output, i - candidate, 2);
+		if (length - 4 >= 15)
+		{
+			writeLength(output, length - 4 - 15);
+		}
+
+		i += length;
+		anchor = i;
+	}
+
+	// The last sequence is only literals.
+	std::size_t literals = sourceSize - anchor;
+	output.push_back(char(std::min<std::size_t>(literals, 15) << 4));
+	if (literals >= 15)
+	{
+		writeLength(output, literals - 15);
+	}
+	output.insert(output.end(), source + anchor, source + sourceSize);
+
+	return output;
+}
+
+bool AssetArchive::decompress(const char* source, std::size_t sourceSize, char* destination, std::size_t destinationSize)
+{
+	const unsigned char* in = (const unsigned char*)source;
+	const unsigned char* end = in + sourceSize;
+	std::size_t out = 0;
+
+	while (in < end)
+	{
+		int token = *in++;
+
+		// Copy the literals.
+		std::size_t literals = token >> 4;
+		if (literals == 15)
+		{
+			unsigned char extra = 255;
+			while (extra == 255)
+			{
+				if (in >= end)
+				{
+					return false;
+				}
+				extra = *in++;
+				literals += extra;
+			}
+		}
+		if (literals > std::size_t(end - in) || literals > destinationSize - out)
+		{
+			return false;
+		}
+		std::memcpy(destination + out, in, literals);
+		in += literals;
+		out += literals;
+
+		// The last sequence has no match.
+		if (in == end)
+		{
+			break;
+		}
+
+		// Copy the match a byte at a time, as it can overlap the bytes being written.
+		if (end - in < 2)
+		{
+			return false;
+		}
+		std::size_t offset = in[0] | (in[1] << 8);
+		in += 2;
+		std::size_t length = token & 15;
+		if (length == 15)
+		{
+			unsigned char extra = 255;
+			while (extra == 255)
+			{
+				if (in >= end)
+				{
+					return false;
+				}
+				extra = *in++;
+				length += extra;
+			}
+		}
+		length += 4;
+		if (offset == 0 || offset > out || length > destinationSize - out)
+		{
+			return false;
+		}
+		for (std::size_t j = 0; j < length; j++)
+		{
+			destination[out + j] = destination[out - offset + j];
+		}
+		out += length;
+	}
+
+	return out == destinationSize;
+}
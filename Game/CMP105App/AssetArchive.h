@@ -0,0 +1,86 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+
+// Asset archive class. Packs the game's fonts, sprites and level descriptions into one file (made by running with "-pack-assets"), so there is one file to ship and open instead of one per asset.
+// The archive starts with a directory of every file's name, offset and size, and is memory mapped, so files are read straight out of it with loadFromMemory without opening anything.
+// Files that are smaller compressed are stored in the LZ4 block format and decompressed the first time they are asked for. The rest (PNGs, which are already compressed) are stored as they are.
+// If the archive is missing, or a file isn't in it, the loose file is loaded instead, so the game still runs from the asset folders while developing.
+class AssetArchive
+{
+public:
+	AssetArchive();
+	AssetArchive(std::string filename);
+	~AssetArchive();
+
+	// Archive shared by the whole game, opened from archiveFile the first time it is used.
+	static AssetArchive& getShared();
+
+	// Map an archive into memory and read its directory. Returns false if it is missing or isn't a valid archive.
+	bool open(std::string filename);
+	void close();
+
+	// Pack the given files (paths relative to the game's folder) into an archive. Files that are missing are skipped. Returns false if the archive couldn't be written.
+	static bool pack(std::string filename, const std::vector<std::string>& files);
+
+	// Get a file's contents from the archive. Stored files point into the mapped archive, and compressed ones into a copy kept until the archive is closed. Returns false if the file isn't in the archive.
+	bool getData(std::string filename, const char*& fileData, std::size_t& fileSize);
+
+	// Load a file from the archive, or from the loose file if it isn't in it. Fonts read from the archive keep using its memory, which stays mapped for as long as the game runs.
+	// ----
+	bool loadImage(sf::Image& image, std::string filename);
+	bool loadTexture(sf::Texture& texture, std::string filename);
+	bool loadFont(sf::Font& font, std::string filename);
+	bool loadText(std::string& text, std::string filename);
+	// ----
+
+	// Size of a file in bytes, or 0 if it is in neither the archive nor the asset folders.
+	std::size_t getFileSize(std::string filename);
+
+	// Getter functions.
+	// ----
+	bool isOpen()
+	{
+		return data != nullptr;
+	};
+
+	int getFileCount()
+	{
+		return int(entries.size());
+	};
+	// ----
+
+	// Where the archive is saved, and the files packed into it.
+	static const std::string archiveFile;
+	static const std::vector<std::string> packedFiles;
+
+private:
+	// A file in the archive. Compressed files have a stored size smaller than their size.
+	struct Entry
+	{
+		std::size_t offset;
+		std::size_t size;
+		std::size_t storedSize;
+	};
+
+	// LZ4 block format compression. decompress() returns false if the data is corrupt or doesn't decompress to exactly size bytes.
+	static std::vector<char> compress(const char* source, std::size_t sourceSize);
+	static bool decompress(const char* source, std::size_t sourceSize, char* destination, std::size_t destinationSize);
+
+	// Mapped archive, and its directory.
+	const char* data;
+	std::size_t size;
+	std::map<std::string, Entry> entries;
+
+	// Compressed files that have been decompressed. Files can be loaded from the asset loader's threads, so this is only touched while holding mutex.
+	std::map<std::string, std::vector<char>> decompressed;
+	std::mutex mutex;
+};
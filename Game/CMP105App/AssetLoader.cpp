@@ -0,0 +1,124 @@
+#include "AssetLoader.h"
+
+AssetLoader::AssetLoader()
+{
+	working = 0;
+	stopping = false;
+
+	// Leave a core for the main thread. Decoding a handful of images doesn't need more than a few threads.
+	int threads = std::min(std::max(int(std::thread::hardware_concurrency()) - 1, 1), 4);
+	for (int i = 0; i < threads; i++)
+	{
+		workers.push_back(std::thread(&AssetLoader::runWorker, this));
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	// Let each thread finish the job it is on, then stop.
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobQueued.notify_all();
+
+	for (int i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+AssetLoader& AssetLoader::getShared()
+{
+	static AssetLoader loader;
+	return loader;
+}
+
+void AssetLoader::queue(std::function<void()> work, std::function<void()> done)
+{
+	Job job;
+	job.work = work;
+	job.done = done;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		waiting.push_back(job);
+	}
+	jobQueued.notify_one();
+}
+
+void AssetLoader::loadTexture(std::string filename, std::function<void(std::shared_ptr<sf::Texture>)> done)
+{
+	// Decode into an image in the background, then upload it through the cache, which hands out the existing texture if something else loaded it in the meantime.
+	std::shared_ptr<sf::Image> image = std::make_shared<sf::Image>();
+	queue([image, filename]()
+	{
+		AssetArchive::getShared().loadImage(*image, filename);
+	},
+	[image, filename, done]()
+	{
+		done(ResourceCache::getShared().getTexture(filename, *image));
+	});
+}
+
+void AssetLoader::runWorker()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobQueued.wait(lock, [this]() { return stopping || !waiting.empty(); });
+			if (stopping)
+			{
+				return;
+			}
+			job = waiting.front();
+			waiting.pop_front();
+			working++;
+		}
+
+		job.work();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finished.push_back(job);
+			working--;
+		}
+		jobFinished.notify_all();
+	}
+}
+
+void AssetLoader::update()
+{
+	// Take the finished jobs, then run their main thread parts without holding the lock, as they can queue more jobs.
+	std::vector<Job> jobs;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.swap(finished);
+	}
+
+	for (int i = 0; i < jobs.size(); i++)
+	{
+		jobs[i].done();
+	}
+}
+
+void AssetLoader::finish()
+{
+	// Main thread parts can queue more jobs, so keep going until nothing is left.
+	while (!isFinished())
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobFinished.wait(lock, [this]() { return waiting.empty() && working == 0; });
+		}
+		update();
+	}
+}
+
+bool AssetLoader::isFinished()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return waiting.empty() && working == 0 && finished.empty();
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include "ResourceCache.h"
+
+// Asset loader class. Loads assets on a pool of background threads, so the main menu can be shown while larger assets (such as the texture atlas and character previews) are still being decoded.
+// Each job has a part run on a background thread (decoding files into memory) and a part run on the main thread once it is done (uploading to the GPU, which OpenGL needs doing on the thread that draws).
+// The main thread parts are run by update(), which is called every frame. finish() waits for everything, for when assets are needed straight away.
+class AssetLoader
+{
+public:
+	AssetLoader();
+	~AssetLoader();
+
+	// Loader shared by the whole game. Objects queue their assets in their constructors, before anything can be passed to them, so they use this one.
+	static AssetLoader& getShared();
+
+	// Queue a job. work runs on a background thread, then done runs on the main thread during a later update().
+	void queue(std::function<void()> work, std::function<void()> done);
+
+	// Load a texture through the shared resource cache, decoding it in the background if it isn't already loaded. done is given the texture on the main thread.
+	void loadTexture(std::string filename, std::function<void(std::shared_ptr<sf::Texture>)> done);
+
+	// Run the main thread part of every job that has finished.
+	void update();
+
+	// Wait for every queued job to finish, and run their main thread parts.
+	void finish();
+
+	// Check whether every job has finished and had its main thread part run.
+	bool isFinished();
+
+private:
+	// A queued job.
+	struct Job
+	{
+		std::function<void()> work;
+		std::function<void()> done;
+	};
+
+	// Function run by each background thread. Takes jobs off the queue until the loader is destroyed.
+	void runWorker();
+
+	std::vector<std::thread> workers;
+
+	// Jobs waiting for a thread, jobs finished and waiting for their main thread part, and the number being worked on. Only touched while holding mutex.
+	std::deque<Job> waiting;
+	std::vector<Job> finished;
+	int working;
+	bool stopping;
+
+	std::mutex mutex;
+	std::condition_variable jobQueued;
+	std::condition_variable jobFinished;
+};
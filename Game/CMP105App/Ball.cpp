@@ -3,17 +3,17 @@
 Ball::Ball()
 {
 	// Initialise variables.
-	velocity.x = 0;
-	velocity.y = 0;
-
-	position.x = 0;
-	position.y = 0;
+	world = nullptr;
+	body = 0;
 
 	lagPosition.x = 0;
 	lagPosition.y = 0;
 
 	interpolating = false;
 
+	// The error left after a second of interpolating is e^-8 (0.03%) of the starting error.
+	errorDecay = 8;
+
 	gravity = 9.8;
 	drag = 0.5;
 	gameScale = 100;
@@ -25,49 +25,49 @@ Ball::~Ball()
 {
 }
 
+void Ball::setBody(PhysicsWorld* w, int b)
+{
+	world = w;
+	body = b;
+
+	// The world moves the ball with its gravity and drag.
+	world->setGravity(body, gravity * gameScale);
+	world->setDrag(body, drag);
+}
+
 void Ball::update(float dt)
 {
-	// Set velocity along x axis. Slow the ball down to simulate drag.
-	velocity.x -= velocity.x * drag * dt;
-	
-	// Checks if the ball is either on the floor, or on top of each of the goals. If it is, set velocity in y axis to 0 to prevent it from falling through the ground.
-	if ((position.y > 575 - (getSize().y / 2) + 1 && velocity.y > -10) || ((position.y > 375 - (getSize().y / 2) + 1) && (position.y < 385 - (getSize().y / 2) + 1) && (position.x < 170 || position.x > 1030) && velocity.y > -10))
-	{
-		velocity.y = 0;
-	}
-	else // Otherwise, increase ball's y velocity by gravity.
-	{
-		velocity.y += gravity * gameScale * dt;
-	}
+	sf::Vector2f velocity = world->getVelocity(body);
+
+	// Checks if the ball is sitting on top of anything in the arena, such as the floor or the goals, and isn't moving up or down quickly. If it is, the ball rests and its velocity in y axis is set to 0 to prevent it from falling through the ground.
+	bool resting = world->isResting(body);
+	world->setFlag(body, PhysicsWorld::RESTING, resting);
 
-	// Calculate position based on previously calculated velocity.
-	position += velocity * dt;
+	// Apply drag and gravity, then move the ball. The ball is swept along its path so it bounces off anything it reaches during the step, rather than passing through it when it is moving fast.
+	world->integrateSwept(body, dt);
+	sf::Vector2f position = world->getPosition(body);
+	velocity = world->getVelocity(body);
 	
-	// Interpolation moves the ball in a straight line towards the desired position. Moves at triple the speed so that it catches up with the actual position quickly without looking like the ball has just teleported.
-	// Potential to improve this in the future by storing the positions for each step when collision is simulated after receiving the data from other client. Then interpolate between those positions so that it follows the ball's actual path as current method can be janky in high latencies.
+	// While interpolating, the ball is drawn offset from its actual position by the error it had when a collision was received, and the error shrinks by the same fraction every second.
+	// The drawn ball follows the shape of the actual path (including any bounces) while it catches up, rather than cutting across it in a straight line, and slows down smoothly as it arrives.
 	// The ball is told to interpolate whenever the client receives a collision packet.
 	if (interpolating)
 	{
-		// Calculate how close the ball is to the desired position.
-		sf::Vector2f posDif = position - lagPosition;
+		drawError *= std::exp(-errorDecay * dt);
 
-		// Once the ball is close enough to the desired position, stop interpolating.
-		if (abs(posDif.x) < 10.0f && abs(posDif.y < 10.0f))
+		// Once the error is too small to see, stop interpolating.
+		if (abs(drawError.x) < 0.5f && abs(drawError.y) < 0.5f)
 		{
 			interpolating = false;
 		}
-
-		// Move the ball towards the desired position.
-		sf::Vector2f dir = calculateDirection(lagPosition, position);
-		lagPosition.x += dir.x * abs(velocity.x) * 3 * dt;
-		lagPosition.y += dir.y * abs(velocity.y) * 3 * dt;
 	}
-	
-	// When not interpolating, set the lagged position to be equal to the calculated position.
-	if(!interpolating)
+
+	// When not interpolating, the ball is drawn at its actual position.
+	if (!interpolating)
 	{
-		lagPosition = position;
+		drawError = sf::Vector2f(0, 0);
 	}
+	lagPosition = position + drawError;
 
 	// Set hitbox to the ball's actual position, not the position that is lagged behind. When lagged position has caught up, the hit box will be at exactly the correct position.
 	sf::Vector2f hitboxOffset = position - lagPosition;
@@ -80,18 +80,7 @@ void Ball::update(float dt)
 	rotate(velocity.x / 100);
 }
 
-sf::Vector2f Ball::calculateDirection(sf::Vector2f pos1, sf::Vector2f pos2)
+void Ball::advance(float time)
 {
-	sf::Vector2f output;
-
-	// Difference in positions.
-	output = pos2 - pos1;
-	
-	// Magnitude of the vector.
-	float magnitude = sqrt(pow(output.x, 2) + pow(output.y, 2));
-
-	// Convert to unit vector by dividing by magnitude.
-	output = output / magnitude;
-
-	return output;
-}
\ No newline at end of file
+	world->advance(body, time);
+}
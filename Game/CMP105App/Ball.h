@@ -1,7 +1,9 @@
 #pragma once
 #include "Framework/GameObject.h"
+#include "PhysicsWorld.h"
 #include <iostream>
 // Ball class - all of the ball's movement and physics is handled here, including interpolation.
+// The ball's actual position and velocity are stored in the physics world. The ball object itself only holds what is needed for drawing it, which lags behind while interpolating.
 class Ball : public GameObject
 {
 public:
@@ -12,24 +14,30 @@ public:
 	// Update the ball using delta time, or the physics step time.
 	void update(float dt);
 
+	// Move the ball's actual position forward by the given time in one go, such as to catch up after a delayed collision. The drawn position isn't changed.
+	void advance(float time);
+
+	// Set the physics world body that holds the ball's position and velocity. Must be called before the ball is used.
+	void setBody(PhysicsWorld* w, int b);
+
 	// Setter functions for velocity, actual position, lagged position and whether the ball is interpolating.
 	// ----
 	void setVelocity(float x, float y)
 	{
-		velocity.x = x;
-		velocity.y = y;
+		world->setVelocity(body, sf::Vector2f(x, y));
 	};
 
 	void setPositionXY(float x, float y)
 	{
-		position.x = x;
-		position.y = y;
+		world->setPosition(body, sf::Vector2f(x, y));
 	}
 
+	// The ball interpolates from the lagged position, so setting it also sets the error between it and the actual position.
 	void setLagPosition(float x, float y)
 	{
 		lagPosition.x = x;
 		lagPosition.y = y;
+		drawError = lagPosition - getPositionXY();
 	}
 
 	void setInterpolating(bool b)
@@ -38,11 +46,16 @@ public:
 	}
 	// ----
 
-	// Getter functions for the ball's velocity, drag, gravity, and centre.
+	// Getter functions for the ball's velocity, actual position, drag, gravity, and centre.
 	// ----
 	sf::Vector2f getVelocity()
 	{
-		return velocity;
+		return world->getVelocity(body);
+	}
+
+	sf::Vector2f getPositionXY()
+	{
+		return world->getPosition(body);
 	}
 
 	float getDrag()
@@ -61,14 +74,17 @@ public:
 	}
 	// ----
 private:
-	// Function to calculate direction between two points. Used for working out the direction that the ball will move in when interpolating.
-	sf::Vector2f calculateDirection(sf::Vector2f pos1, sf::Vector2f pos2);
+	// Physics world and the ball's body in it.
+	PhysicsWorld* world;
+	int body;
 
-	// Velocity and position vectors.
-	sf::Vector2f velocity;
-	sf::Vector2f position;
+	// Position the ball is drawn at.
 	sf::Vector2f lagPosition;
 
+	// Offset of the drawn position from the actual position, and how quickly it shrinks while interpolating (fraction per second, as an exponential rate).
+	sf::Vector2f drawError;
+	float errorDecay;
+
 	// A boolean to hold whether the ball should be interpolating or not. This is set to true in the network manager when it handles received collisions.
 	bool interpolating;
 
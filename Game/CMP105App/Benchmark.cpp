@@ -0,0 +1,883 @@
+#include "Benchmark.h"
+
+// Allocations are counted while a benchmark exists, so text cases can report how many they make each frame. The game never creates one, so outside the benchmark each allocation only pays for checking whether to count.
+// Only the benchmark's own thread is counted, so the count doesn't need to be atomic.
+static std::atomic<bool> countingAllocations(false);
+static thread_local long long allocationCount = 0;
+
+static void* allocate(std::size_t size) noexcept
+{
+	if (countingAllocations.load(std::memory_order_relaxed))
+	{
+		allocationCount++;
+	}
+	return std::malloc(size > 0 ? size : 1);
+}
+
+// Replacing operator new replaces it for the whole program, so every form is replaced to go through the same allocator.
+// ----
+void* operator new(std::size_t size)
+{
+	void* memory = allocate(size);
+	if (!memory)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+	void* memory = allocate(size);
+	if (!memory)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+// ----
+
+Benchmark::Benchmark() : grid(sf::Vector2f(1200, 675), 150)
+{
+	// Count allocations until the benchmark is finished with.
+	countingAllocations = true;
+
+	// Same arena size as the game window.
+	objectManager.initHeadless(sf::Vector2u(1200, 675));
+
+	// Runs must take at least half a second, and each case is run 5 times.
+	minTime = 0.5;
+	repetitions = 5;
+
+	// Simulate one second from each starting state.
+	stepsPerState = 180;
+
+	// Set default values
+	// ----
+	currentState = 0;
+	sink = 0;
+	errorTotal = 0;
+	errorMax = 0;
+	errorSamples = 0;
+	drawCallTotal = 0;
+	drawCallFrames = 0;
+	memoryTotal = 0;
+	memorySteps = 0;
+	allocationTotal = 0;
+	allocationFrames = 0;
+	// ----
+
+	// Fixed seeds so every run uses the same conditions, including the random shot height in kickBall.
+	generateStates(stateCount);
+	objectManager.seedKicks(0);
+
+	// Many ball bodies in one physics world, such as many matches running on one server.
+	for (int i = 0; i < 1024; i++)
+	{
+		int body = manyBodies.addBody(sf::FloatRect(states[i].ballPosition, sf::Vector2f(50, 50)), 0);
+		manyBodies.setVelocity(body, states[i].ballVelocity);
+		manyBodies.setGravity(body, 980);
+		manyBodies.setDrag(body, 0.5);
+	}
+
+	// A ball and 22 players.
+	crowd.addBody(sf::FloatRect(0, 0, 50, 50), 0);
+	for (int i = 0; i < 22; i++)
+	{
+		crowd.addBody(sf::FloatRect(0, 0, 100, 100), 0);
+	}
+
+	Ball* ball = objectManager.getBall();
+	Player* player = objectManager.getControlledPlayer();
+	float dt = objectManager.getPhysicsStep();
+
+	// Cost of moving the ball and player to the next starting state. Cases that change state every step include this.
+	addCase("Benchmark::nextState", [this](long long steps)
+	{
+		for (long long i = 0; i < steps; i++)
+		{
+			nextState();
+		}
+	});
+
+	// Ball and player updates. The objects move freely from each starting state.
+	addCase("Ball::update", [this, ball, dt](long long steps)
+	{
+		for (long long i = 0; i < steps; i++)
+		{
+			if (i % stepsPerState == 0)
+			{
+				nextState();
+			}
+			ball->update(dt);
+		}
+	});
+
+	// Swept ball movement at the game's physics rate and at lower rates a server could run at. Each step simulates one second of play from a new starting state, so the times compare the cost per second of each rate.
+	int rates[] = { 180, 60, 30 };
+	for (int rate : rates)
+	{
+		addCase("Ball::update/" + std::to_string(rate) + "Hz", [this, ball, rate](long long steps)
+		{
+			for (long long i = 0; i < steps; i++)
+			{
+				nextState();
+				for (int j = 0; j < rate; j++)
+				{
+					ball->update(1.0f / rate);
+				}
+			}
+		});
+	}
+
+	// Catching the ball up after a delayed collision, by stepping the physics as far as the latency and by solving its path contact to contact.
+	int latencies[] = { 50, 150, 300 };
+	for (int latency : latencies)
+	{
+		float time = latency / 1000.0f;
+		addCase("Ball catch up stepped/" + std::to_string(latency) + "ms", [this, ball, dt, time](long long steps)
+		{
+			for (long long i = 0; i < steps; i++)
+			{
+				nextState();
+				for (float simTime = 0; simTime < time; simTime += dt)
+				{
+					objectManager.checkBallCollision();
+					ball->update(dt);
+				}
+			}
+		});
+
+		addCase("Ball catch up analytic/" + std::to_string(latency) + "ms", [this, ball, time](long long steps)
+		{
+			for (long long i = 0; i < steps; i++)
+			{
+				nextState();
+				objectManager.checkBallCollision();
+				ball->advance(time);
+			}
+		});
+	}
+
+	// Smoothing the ball after a collision arrives late. Before it arrives the ball carries on as if it hadn't been hit (bouncing back the way it came), then it is corrected the same way as NetworkManager::setBallState() and drawn catching up over the next second.
+	for (int latency : latencies)
+	{
+		float time = latency / 1000.0f;
+		addCase("Ball smoothing/" + std::to_string(latency) + "ms", [this, ball, dt, time](long long steps)
+		{
+			for (long long i = 0; i < steps; i++)
+			{
+				nextState();
+				sf::Vector2f position = ball->getPositionXY();
+				sf::Vector2f velocity = ball->getVelocity();
+
+				ball->setVelocity(-velocity.x, velocity.y);
+				for (float simTime = 0; simTime < time; simTime += dt)
+				{
+					ball->update(dt);
+				}
+
+				sf::Vector2f previousPos = ball->getPosition();
+				ball->setPositionXY(position.x, position.y);
+				ball->setVelocity(velocity.x, velocity.y);
+				objectManager.checkBallCollision();
+				ball->advance(time);
+				ball->setLagPosition(previousPos.x, previousPos.y);
+				ball->setInterpolating(true);
+
+				for (int j = 0; j < stepsPerState; j++)
+				{
+					ball->update(dt);
+					measureError();
+				}
+			}
+		});
+	}
+
+	addCase("Player::update", [this, player, dt](long long steps)
+	{
+		for (long long i = 0; i < steps; i++)
+		{
+			if (i % stepsPerState == 0)
+			{
+				nextState();
+			}
+			player->update(dt);
+		}
+	});
+
+	// Collision checks. The state changes every step so that every check sees different conditions.
+	addCase("ObjectManager::checkBallCollision", [this](long long steps)
+	{
+		for (long long i = 0; i < steps; i++)
+		{
+			nextState();
+			objectManager.checkBallCollision();
+		}
+	});
+
+	addCase("ObjectManager::checkPlayerCollision", [this, player](long long steps)
+	{
+		for (long long i = 0; i < steps; i++)
+		{
+			nextState();
+			objectManager.checkPlayerCollision(player);
+		}
+	});
+
+	addCase("ObjectManager::checkPlayerBallCollision", [this](long long steps)
+	{
+		for (long long i = 0; i < steps; i++)
+		{
+			nextState();
+			objectManager.checkPlayerBallCollision();
+		}
+	});
+
+	// Finding which players and balls touch, by testing every pair and with the spatial grid, from 2v2 to 11v11. Bodies move to new positions every step, with about half of the players near the ball.
+	int teamSizes[] = { 2, 5, 11 };
+	for (int teamSize : teamSizes)
+	{
+		std::string name = std::to_string(teamSize) + "v" + std::to_string(teamSize);
+		int count = teamSize * 2 + 1;
+
+		addCase("Broadphase brute force/" + name, [this, count](long long steps)
+		{
+			int n = 0;
+			for (long long i = 0; i < steps; i++)
+			{
+				moveCrowd(n, count);
+				pairs.clear();
+				for (int a = 0; a < count; a++)
+				{
+					for (int b = a + 1; b < count; b++)
+					{
+						if (crowd.overlaps(a, b))
+						{
+							pairs.push_back(std::make_pair(a, b));
+						}
+					}
+				}
+				sink += pairs.size();
+				n = (n + count) % stateCount;
+			}
+		});
+
+		addCase("SpatialGrid/" + name, [this, count](long long steps)
+		{
+			int n = 0;
+			for (long long i = 0; i < steps; i++)
+			{
+				moveCrowd(n, count);
+				pairs.clear();
+				grid.build(crowd, 0, count);
+				grid.findPairs(crowd, pairs);
+				sink += pairs.size();
+				n = (n + count) % stateCount;
+			}
+		});
+	}
+
+	// Integrating every body in a world. Time is for all 1024 bodies.
+	addCase("PhysicsWorld::integrate/1024", [this, dt](long long steps)
+	{
+		for (long long i = 0; i < steps; i++)
+		{
+			manyBodies.integrate(dt);
+		}
+	});
+
+	// Testing the ball against the six arena colliders, with the old per-pair function and with the physics world one pair at a time and all at once. The ball moves to a new position every step.
+	PhysicsWorld* world = objectManager.getWorld();
+	int ballBody = objectManager.getBallBody();
+	int arenaBody = objectManager.getArenaBody();
+	int arenaBodyCount = objectManager.getArenaBodyCount();
+
+	addCase("Collision::checkBoundingBox/6", [this, ball](long long steps)
+	{
+		GameObject* arena[6] = { objectManager.getFloor(), objectManager.getCeiling(), objectManager.getLeftWall(), objectManager.getRightWall(), objectManager.getLeftGoal(), objectManager.getRightGoal() };
+		unsigned int hits = 0;
+		int n = 0;
+		for (long long i = 0; i < steps; i++)
+		{
+			ball->setPosition(states[n].ballPosition);
+			for (int j = 0; j < 6; j++)
+			{
+				hits += Collision::checkBoundingBox(ball, arena[j]);
+			}
+			n = (n + 1) % stateCount;
+		}
+		sink += hits;
+	});
+
+	addCase("PhysicsWorld::overlaps/6", [this, world, ballBody, arenaBody, arenaBodyCount](long long steps)
+	{
+		unsigned int hits = 0;
+		int n = 0;
+		for (long long i = 0; i < steps; i++)
+		{
+			world->setPosition(ballBody, states[n].ballPosition);
+			for (int j = 0; j < arenaBodyCount; j++)
+			{
+				hits += world->overlaps(ballBody, arenaBody + j);
+			}
+			n = (n + 1) % stateCount;
+		}
+		sink += hits;
+	});
+
+	addCase("PhysicsWorld::overlapMask/6", [this, world, ballBody, arenaBody, arenaBodyCount](long long steps)
+	{
+		unsigned int hits = 0;
+		int n = 0;
+		for (long long i = 0; i < steps; i++)
+		{
+			world->setPosition(ballBody, states[n].ballPosition);
+			hits += world->overlapMask(ballBody, arenaBody, arenaBodyCount);
+			n = (n + 1) % stateCount;
+		}
+		sink += hits;
+	});
+
+	// Testing one body against every body in a large world. Time is for all 1024 tests.
+	addCase("PhysicsWorld::overlapMask/1024", [this](long long steps)
+	{
+		unsigned int mask[32];
+		unsigned int hits = 0;
+		int n = 0;
+		for (long long i = 0; i < steps; i++)
+		{
+			manyBodies.setPosition(0, states[n].ballPosition);
+			manyBodies.overlapMask(0, 0, manyBodies.getBodyCount(), mask);
+			hits += mask[0];
+			n = (n + 1) % stateCount;
+		}
+		sink += hits;
+	});
+
+	// A full physics step, in the same order as ObjectManager::update.
+	addCase("ObjectManager physics step", [this, ball, player, dt](long long steps)
+	{
+		for (long long i = 0; i < steps; i++)
+		{
+			if (i % stepsPerState == 0)
+			{
+				nextState();
+			}
+			objectManager.checkBallCollision();
+			objectManager.checkPlayerCollision(player);
+			ball->update(dt);
+			objectManager.checkPlayerBallCollision();
+			player->update(dt);
+		}
+	});
+
+	// Whole matches from 1v1 to 5v5, with every player simulated and all but the first following the ball on their own. Time is for one physics step of the whole match.
+	int matchSizes[] = { 1, 2, 5 };
+	for (int teamSize : matchSizes)
+	{
+		std::string name = std::to_string(teamSize) + "v" + std::to_string(teamSize);
+		addCase("ObjectManager::stepPhysics/" + name, [this, teamSize](long long steps)
+		{
+			objectManager.setTeamSize(teamSize);
+			objectManager.goalReset();
+			for (long long i = 0; i < steps; i++)
+			{
+				if (i % stepsPerState == 0)
+				{
+					nextState();
+				}
+				objectManager.stepPhysics();
+			}
+			objectManager.setTeamSize(1);
+		});
+	}
+
+	// Loading the fonts and textures the main menu, lobby and object manager load when the game starts, with each loading its own copy and through the resource cache. Time is for one startup.
+	// Each loads the font, the menus each have a cursor, and the lobby has every character.
+	std::vector<std::string> startupFonts = { "font/arial.ttf", "font/arial.ttf", "font/arial.ttf" };
+	std::vector<std::string> startupTextures = { "gfx/icon.png", "gfx/icon.png", "gfx/messi.png", "gfx/ronaldo.png", "gfx/kirby.png", "gfx/miedema.png" };
+
+	addCase("Startup loading/uncached", [this, startupFonts, startupTextures](long long steps)
+	{
+		for (long long i = 0; i < steps; i++)
+		{
+			std::vector<sf::Font> fonts(startupFonts.size());
+			std::vector<sf::Texture> textures(startupTextures.size());
+			for (int j = 0; j < fonts.size(); j++)
+			{
+				fonts[j].loadFromFile(startupFonts[j]);
+				memoryTotal += ResourceCache::getFileSize(startupFonts[j]);
+			}
+			for (int j = 0; j < textures.size(); j++)
+			{
+				textures[j].loadFromFile(startupTextures[j]);
+				memoryTotal += double(textures[j].getSize().x) * textures[j].getSize().y * 4;
+			}
+			memorySteps++;
+		}
+	}, 10);
+
+	addCase("Startup loading/ResourceCache", [this, startupFonts, startupTextures](long long steps)
+	{
+		for (long long i = 0; i < steps; i++)
+		{
+			ResourceCache cache;
+			std::vector<std::shared_ptr<sf::Font>> fonts;
+			std::vector<std::shared_ptr<sf::Texture>> textures;
+			for (int j = 0; j < startupFonts.size(); j++)
+			{
+				fonts.push_back(cache.getFont(startupFonts[j]));
+			}
+			for (int j = 0; j < startupTextures.size(); j++)
+			{
+				textures.push_back(cache.getTexture(startupTextures[j]));
+			}
+			memoryTotal += double(cache.getBytesLoaded());
+			memorySteps++;
+		}
+	}, 10);
+
+	// The same loading with every file read from the asset archive instead of opened on its own. Skipped if there isn't an archive.
+	if (AssetArchive::getShared().isOpen())
+	{
+		addCase("Startup loading/AssetArchive", [this, startupFonts, startupTextures](long long steps)
+		{
+			AssetArchive& archive = AssetArchive::getShared();
+			for (long long i = 0; i < steps; i++)
+			{
+				std::vector<sf::Font> fonts(startupFonts.size());
+				std::vector<sf::Texture> textures(startupTextures.size());
+				for (int j = 0; j < fonts.size(); j++)
+				{
+					archive.loadFont(fonts[j], startupFonts[j]);
+					memoryTotal += archive.getFileSize(startupFonts[j]);
+				}
+				for (int j = 0; j < textures.size(); j++)
+				{
+					archive.loadTexture(textures[j], startupTextures[j]);
+					memoryTotal += double(textures[j].getSize().x) * textures[j].getSize().y * 4;
+				}
+				memorySteps++;
+			}
+		}, 10);
+	}
+
+	// Updating the match's ping, score and timer text for a frame, building strings and sf::Text as the HUD used to, and with HUD text. The timer changes every frame and the ping every second.
+	std::shared_ptr<sf::Font> hudFont = ResourceCache::getShared().getFont("font/arial.ttf");
+	sf::Text hudStyle;
+	hudStyle.setFont(*hudFont);
+	hudStyle.setCharacterSize(20);
+	hudStyle.setOutlineThickness(1);
+
+	addCase("HUD text/sf::Text", [this, hudFont, hudStyle](long long steps)
+	{
+		sf::Text ping = hudStyle;
+		sf::Text score = hudStyle;
+		sf::Text time = hudStyle;
+		for (long long i = 0; i < steps; i++)
+		{
+			long long allocations = allocationCount;
+
+			ping.setString("Ping: " + std::to_string(40 + (i / 60) % 10));
+			score.setString(std::to_string(1) + " - " + std::to_string(2));
+			std::stringstream stream;
+			stream << "Time: " << std::fixed << std::setprecision(2) << i / 60.0f;
+			time.setString(stream.str());
+			sink += ping.getGlobalBounds().width + score.getGlobalBounds().width + time.getGlobalBounds().width;
+
+			allocationTotal += allocationCount - allocations;
+			allocationFrames++;
+		}
+	});
+
+	addCase("HUD text/HudText", [this, hudFont, hudStyle](long long steps)
+	{
+		HudText ping;
+		HudText score;
+		HudText time;
+		ping.setStyle(hudStyle);
+		score.setStyle(hudStyle);
+		time.setStyle(hudStyle);
+		char buffer[HudText::maxLength + 1];
+		for (long long i = 0; i < steps; i++)
+		{
+			long long allocations = allocationCount;
+
+			std::snprintf(buffer, sizeof(buffer), "Ping: %d", int(40 + (i / 60) % 10));
+			ping.setString(buffer);
+			std::snprintf(buffer, sizeof(buffer), "%d - %d", 1, 2);
+			score.setString(buffer);
+			std::snprintf(buffer, sizeof(buffer), "Time: %.2f", i / 60.0f);
+			time.setString(buffer);
+			sink += ping.getGlobalBounds().width + score.getGlobalBounds().width + time.getGlobalBounds().width;
+
+			allocationTotal += allocationCount - allocations;
+			allocationFrames++;
+		}
+	});
+
+	// Rendering a frame off-screen: recording it into a snapshot, then drawing it, with each object on its own and with the sprite batch. Time is for one frame, including the GPU catching up.
+	canRender = frame.create(objectManager.getArenaSize().x, objectManager.getArenaSize().y);
+	if (!canRender)
+	{
+		std::cout << "Could not create a render texture. Skipping rendering benchmarks.\n";
+		return;
+	}
+
+	for (int teamSize : matchSizes)
+	{
+		std::string name = std::to_string(teamSize) + "v" + std::to_string(teamSize);
+		for (int batched = 0; batched < 2; batched++)
+		{
+			addCase(std::string("ObjectManager::render/") + (batched ? "batched/" : "unbatched/") + name, [this, teamSize, batched](long long steps)
+			{
+				objectManager.setTeamSize(teamSize);
+				objectManager.goalReset();
+				objectManager.setBatchSprites(batched != 0);
+				for (long long i = 0; i < steps; i++)
+				{
+					if (i % stepsPerState == 0)
+					{
+						nextState();
+					}
+					snapshot.clear(sf::Color::Black, frame.getDefaultView());
+					objectManager.render(snapshot);
+					snapshot.render(frame);
+					frame.display();
+					drawCallTotal += snapshot.getDrawCalls();
+					drawCallFrames++;
+				}
+				objectManager.setBatchSprites(true);
+				objectManager.setTeamSize(1);
+			});
+		}
+	}
+}
+
+Benchmark::~Benchmark()
+{
+	countingAllocations = false;
+}
+
+void Benchmark::run(std::string outputFile)
+{
+	std::cout << "Running " << cases.size() << " benchmarks, " << repetitions << " repetitions of at least " << minTime << "s each.\n\n";
+	std::cout << std::left << std::setw(45) << "Benchmark" << std::right << std::setw(14) << "Time/step" << std::setw(14) << "Min" << std::setw(14) << "Max" << std::setw(14) << "Steps" << "\n";
+
+	std::vector<Result> results;
+	for (int i = 0; i < cases.size(); i++)
+	{
+		Result result = runCase(cases[i]);
+		results.push_back(result);
+
+		std::cout << std::left << std::setw(45) << result.name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(11) << result.meanTime << " ns" << std::setw(11) << result.minTime << " ns" << std::setw(11) << result.maxTime << " ns"
+			<< std::setw(14) << result.steps << "\n";
+
+		if (result.measuresError)
+		{
+			std::cout << "    visual error: mean " << result.meanError << " px, max " << result.maxError << " px\n";
+		}
+
+		if (result.measuresDrawCalls)
+		{
+			std::cout << "    draw calls: " << result.drawCalls << " per frame\n";
+		}
+
+		if (result.measuresMemory)
+		{
+			std::cout << "    memory loaded: " << result.memory / (1024 * 1024) << " MB per step\n";
+		}
+
+		if (result.measuresAllocations)
+		{
+			std::cout << "    allocations: " << result.allocations << " per frame\n";
+		}
+	}
+
+	saveResults(outputFile, results);
+	std::cout << "\nResults saved to " << outputFile << ".\n";
+}
+
+void Benchmark::addCase(std::string name, std::function<void(long long)> function, long long firstSteps)
+{
+	Case c;
+	c.name = name;
+	c.function = function;
+	c.firstSteps = firstSteps;
+	cases.push_back(c);
+}
+
+// Run a case for the given number of steps, and return how long it took in seconds.
+double Benchmark::timeCase(Case& c, long long steps)
+{
+	// Always start from the same state.
+	currentState = 0;
+	nextState();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	c.function(steps);
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	sink += objectManager.getBall()->getPositionXY().x + objectManager.getControlledPlayer()->getPosition().x;
+
+	return std::chrono::duration<double>(end - start).count();
+}
+
+Benchmark::Result Benchmark::runCase(Case& c)
+{
+	// Increase the number of steps until a run takes at least the minimum time. Aim a little over, and grow by at most 10 times so one slow run can't overshoot.
+	long long steps = c.firstSteps;
+	double elapsed = timeCase(c, steps);
+	while (elapsed < minTime)
+	{
+		double multiplier = elapsed > 0 ? minTime * 1.4 / elapsed : 10;
+		if (multiplier > 10)
+		{
+			multiplier = 10;
+		}
+		else if (multiplier < 2)
+		{
+			multiplier = 2;
+		}
+
+		steps = (long long)(steps * multiplier);
+		elapsed = timeCase(c, steps);
+	}
+
+	// Time the repetitions.
+	Result result;
+	result.name = c.name;
+	result.steps = steps;
+	result.meanTime = 0;
+	result.minTime = 0;
+	result.maxTime = 0;
+
+	errorTotal = 0;
+	errorMax = 0;
+	errorSamples = 0;
+	drawCallTotal = 0;
+	drawCallFrames = 0;
+	memoryTotal = 0;
+	memorySteps = 0;
+	allocationTotal = 0;
+	allocationFrames = 0;
+
+	for (int i = 0; i < repetitions; i++)
+	{
+		double time = timeCase(c, steps) * 1e9 / steps;
+		result.meanTime += time / repetitions;
+
+		if (i == 0 || time < result.minTime)
+		{
+			result.minTime = time;
+		}
+		if (i == 0 || time > result.maxTime)
+		{
+			result.maxTime = time;
+		}
+	}
+
+	// Every repetition steps through the same states, so the error is the same each time.
+	result.measuresError = errorSamples > 0;
+	result.meanError = result.measuresError ? errorTotal / errorSamples : 0;
+	result.maxError = errorMax;
+	result.measuresDrawCalls = drawCallFrames > 0;
+	result.drawCalls = result.measuresDrawCalls ? double(drawCallTotal) / drawCallFrames : 0;
+	result.measuresMemory = memorySteps > 0;
+	result.memory = result.measuresMemory ? memoryTotal / memorySteps : 0;
+	result.measuresAllocations = allocationFrames > 0;
+	result.allocations = result.measuresAllocations ? double(allocationTotal) / allocationFrames : 0;
+
+	return result;
+}
+
+void Benchmark::generateStates(int count)
+{
+	std::mt19937 generator(303);
+	sf::Vector2u size = objectManager.getArenaSize();
+
+	std::uniform_real_distribution<float> x(0, float(size.x));
+	std::uniform_real_distribution<float> y(0, float(size.y));
+	std::uniform_real_distribution<float> ballSpeed(-2000, 2000);
+	std::uniform_real_distribution<float> jumpSpeed(-700, 700);
+	std::uniform_real_distribution<float> offset(-100, 100);
+	std::uniform_int_distribution<int> direction(-1, 1);
+	std::uniform_int_distribution<int> coin(0, 1);
+
+	for (int i = 0; i < count; i++)
+	{
+		State state;
+		state.ballPosition = sf::Vector2f(x(generator), y(generator));
+		state.ballVelocity = sf::Vector2f(ballSpeed(generator), ballSpeed(generator));
+
+		// Half of the time, put the player next to the ball so that they touch.
+		if (coin(generator))
+		{
+			state.playerPosition = state.ballPosition + sf::Vector2f(offset(generator) - 50, offset(generator) - 50);
+		}
+		else
+		{
+			state.playerPosition = sf::Vector2f(x(generator), y(generator));
+		}
+		state.playerVelocity = sf::Vector2f(direction(generator) * 400.0f, jumpSpeed(generator));
+		state.kicking = coin(generator);
+
+		states.push_back(state);
+	}
+}
+
+// Move the ball and player to the next starting state.
+void Benchmark::nextState()
+{
+	State& state = states[currentState];
+	currentState = (currentState + 1) % states.size();
+
+	Ball* ball = objectManager.getBall();
+	ball->setPositionXY(state.ballPosition.x, state.ballPosition.y);
+	ball->setLagPosition(state.ballPosition.x, state.ballPosition.y);
+	ball->setPosition(state.ballPosition);
+	ball->setVelocity(state.ballVelocity.x, state.ballVelocity.y);
+	ball->setInterpolating(false);
+	ball->setCollisionBox(-ball->getSize().x / 2, -ball->getSize().y / 2, ball->getSize().x, ball->getSize().y);
+
+	Player* player = objectManager.getControlledPlayer();
+	player->setPosition(state.playerPosition);
+	player->setVelocity(state.playerVelocity);
+	player->setKicking(state.kicking);
+}
+
+// Move the first count bodies of the crowd to the player positions of the states from n onwards, with the ball at the first state's ball position.
+void Benchmark::moveCrowd(int n, int count)
+{
+	crowd.setPosition(0, states[n].ballPosition);
+	for (int i = 1; i < count; i++)
+	{
+		crowd.setPosition(i, states[(n + i) % stateCount].playerPosition);
+	}
+}
+
+void Benchmark::measureError()
+{
+	Ball* ball = objectManager.getBall();
+	sf::Vector2f error = ball->getPosition() - ball->getPositionXY();
+	double distance = std::sqrt(error.x * error.x + error.y * error.y);
+
+	errorTotal += distance;
+	errorMax = std::max(errorMax, distance);
+	errorSamples++;
+}
+
+void Benchmark::saveResults(std::string outputFile, const std::vector<Result>& results)
+{
+	std::ofstream file(outputFile);
+	if (!file)
+	{
+		std::cout << "Could not open " << outputFile << ".\n";
+		return;
+	}
+
+	// Date the results were recorded.
+	char date[32];
+	std::time_t now = std::time(nullptr);
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+#ifdef _DEBUG
+	std::string buildType = "debug";
+#else
+	std::string buildType = "release";
+#endif
+
+	// Fixed point and float builds of the physics are compared by running the benchmark in each.
+#ifdef PHYSICS_FIXED_POINT
+	std::string numberType = "fixed";
+#else
+	std::string numberType = "float";
+#endif
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\n";
+	file << "  \"context\": {\n";
+	file << "    \"date\": \"" << date << "\",\n";
+	file << "    \"library_build_type\": \"" << buildType << "\",\n";
+	file << "    \"physics_step\": " << objectManager.getPhysicsStep() << ",\n";
+	file << "    \"physics_number_type\": \"" << numberType << "\",\n";
+	file << "    \"starting_states\": " << states.size() << ",\n";
+	file << "    \"steps_per_state\": " << stepsPerState << ",\n";
+	file << "    \"repetitions\": " << repetitions << "\n";
+	file << "  },\n";
+	file << "  \"benchmarks\": [\n";
+
+	for (int i = 0; i < results.size(); i++)
+	{
+		file << "    {\n";
+		file << "      \"name\": \"" << results[i].name << "\",\n";
+		file << "      \"iterations\": " << results[i].steps << ",\n";
+		file << "      \"real_time\": " << results[i].meanTime << ",\n";
+		file << "      \"min_time\": " << results[i].minTime << ",\n";
+		file << "      \"max_time\": " << results[i].maxTime << ",\n";
+		if (results[i].measuresError)
+		{
+			file << "      \"visual_error_mean\": " << results[i].meanError << ",\n";
+			file << "      \"visual_error_max\": " << results[i].maxError << ",\n";
+		}
+		if (results[i].measuresDrawCalls)
+		{
+			file << "      \"draw_calls\": " << results[i].drawCalls << ",\n";
+		}
+		if (results[i].measuresMemory)
+		{
+			file << "      \"resource_bytes\": " << results[i].memory << ",\n";
+		}
+		if (results[i].measuresAllocations)
+		{
+			file << "      \"allocations\": " << results[i].allocations << ",\n";
+		}
+		file << "      \"time_unit\": \"ns\"\n";
+		file << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+
+	file << "  ]\n";
+	file << "}\n";
+}
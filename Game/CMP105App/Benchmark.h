@@ -0,0 +1,137 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <random>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "ObjectManager.h"
+#include "PhysicsWorld.h"
+#include "SpatialGrid.h"
+#include "ResourceCache.h"
+#include "AssetArchive.h"
+#include "HudText.h"
+
+// Benchmark class. Runs the game's physics headlessly (started with "-benchmark [output.json]") and reports the time each part takes per step, so that changes to the physics can be compared against a baseline.
+// Cases are timed in the same way as Google Benchmark: the number of steps is increased until a run takes long enough to time accurately, then that many steps are run several times.
+// Results are printed and saved as JSON for tracking regressions. Starting conditions are random but use a fixed seed, so every run steps through the same conditions.
+class Benchmark
+{
+public:
+	Benchmark();
+	~Benchmark();
+
+	// Run every case, print the results and save them to the given file.
+	void run(std::string outputFile);
+
+private:
+	// A single benchmark. The function runs the physics for the given number of steps. Timing starts from firstSteps, which slow cases set lower.
+	struct Case
+	{
+		std::string name;
+		std::function<void(long long)> function;
+		long long firstSteps;
+	};
+
+	// Time per step of a case in nanoseconds, over all repetitions. Cases that smooth the ball after a correction also report how far it was drawn from its actual position, in pixels, rendering cases report the draw calls per frame, loading cases report the memory loaded per step, and text cases report the allocations made per frame.
+	struct Result
+	{
+		std::string name;
+		long long steps;
+		double meanTime;
+		double minTime;
+		double maxTime;
+		bool measuresError;
+		double meanError;
+		double maxError;
+		bool measuresDrawCalls;
+		double drawCalls;
+		bool measuresMemory;
+		double memory;
+		bool measuresAllocations;
+		double allocations;
+	};
+
+	// Ball and player state that a case starts from.
+	struct State
+	{
+		sf::Vector2f ballPosition;
+		sf::Vector2f ballVelocity;
+		sf::Vector2f playerPosition;
+		sf::Vector2f playerVelocity;
+		bool kicking;
+	};
+
+	// Functions for adding, timing and running cases.
+	void addCase(std::string name, std::function<void(long long)> function, long long firstSteps = 1000);
+	double timeCase(Case& c, long long steps);
+	Result runCase(Case& c);
+
+	// Functions for setting up the starting states, and moving the ball and player to the next one.
+	void generateStates(int count);
+	void nextState();
+
+	// Move players and the ball in the crowd to new positions.
+	void moveCrowd(int n, int count);
+
+	// Add the distance between where the ball is drawn and where it actually is to the visual error.
+	void measureError();
+
+	// Save results in the same layout as Google Benchmark's JSON output.
+	void saveResults(std::string outputFile, const std::vector<Result>& results);
+
+	// Object manager with no window, networking or audio.
+	ObjectManager objectManager;
+
+	// Physics world with many bodies, for timing stepping at scale.
+	PhysicsWorld manyBodies;
+
+	// Players and a ball for the largest team size (11v11), with the ball first. Smaller team sizes use the first bodies. Pairs found each step are put in pairs.
+	PhysicsWorld crowd;
+	SpatialGrid grid;
+	std::vector<std::pair<int, int>> pairs;
+
+	// All cases, and the starting states they cycle through. The number of states is a constant so cycling through them doesn't need a division.
+	static const int stateCount = 4096;
+	std::vector<Case> cases;
+	std::vector<State> states;
+	int currentState;
+
+	// Number of steps simulated from each starting state by cases that move the ball and player.
+	int stepsPerState;
+
+	// Minimum time in seconds for a run to be timed, and how many times each case is run.
+	double minTime;
+	int repetitions;
+
+	// Visual error added up by cases that measure it, over all of a case's repetitions.
+	double errorTotal;
+	double errorMax;
+	long long errorSamples;
+
+	// Off-screen target for rendering cases, which are skipped if it can't be created, and the snapshot each frame is recorded into. Draw calls are added up over all of a case's frames.
+	sf::RenderTexture frame;
+	RenderSnapshot snapshot;
+	bool canRender;
+	long long drawCallTotal;
+	long long drawCallFrames;
+
+	// Bytes loaded by loading cases, added up over all of a case's steps.
+	double memoryTotal;
+	long long memorySteps;
+
+	// Allocations made by text cases, added up over all of a case's frames.
+	long long allocationTotal;
+	long long allocationFrames;
+
+	// Results are added to this after each run, so the compiler can't remove the physics as unused.
+	float sink;
+};
@@ -0,0 +1,82 @@
+#include "BufferedSocket.h"
+
+BufferedSocket::BufferedSocket() : socket(new sf::TcpSocket)
+{
+	socket->setBlocking(false);
+	closed = false;
+	closing = false;
+	closingTimeout = 5;
+}
+
+BufferedSocket::~BufferedSocket()
+{
+}
+
+bool BufferedSocket::send(sf::Packet packet)
+{
+	if (closed)
+	{
+		return false;
+	}
+
+	// The player has stopped reading, so stop queueing for them.
+	if (queued.size() >= maxQueued)
+	{
+		close();
+		return false;
+	}
+
+	queued.push_back(packet);
+	return flush();
+}
+
+bool BufferedSocket::flush()
+{
+	if (closed)
+	{
+		return false;
+	}
+
+	// Send packets from the front of the queue until one can't be sent in full. A partly sent packet stays at the front, and carries on from where it got to next time.
+	while (!queued.empty())
+	{
+		sf::Socket::Status status = socket->send(queued.front());
+		if (status == sf::Socket::Done)
+		{
+			queued.pop_front();
+		}
+		else if (status == sf::Socket::Partial || status == sf::Socket::NotReady)
+		{
+			break;
+		}
+		else
+		{
+			close();
+			return false;
+		}
+	}
+
+	// Close once everything has been sent, or if it is taking too long.
+	if (closing && (queued.empty() || closingClock.getElapsedTime().asSeconds() > closingTimeout))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void BufferedSocket::closeWhenSent()
+{
+	if (!closing)
+	{
+		closing = true;
+		closingClock.restart();
+	}
+	flush();
+}
+
+void BufferedSocket::close()
+{
+	queued.clear();
+	closed = true;
+}
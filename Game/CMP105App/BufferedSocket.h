@@ -0,0 +1,70 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <deque>
+#include <memory>
+
+// Buffered socket class. A TCP socket for the relay and matchmaker servers that never blocks, so one slow player can't hold up everyone else.
+// Packets that can't be sent straight away are queued, and sent by flush() once the socket can send again. Packets arriving in pieces are put back together by SFML, which keeps the part received so far.
+// A player that lets more than maxQueued packets build up isn't keeping up, and is closed rather than queued for forever. The owner removes closed sockets.
+class BufferedSocket
+{
+public:
+	BufferedSocket();
+	~BufferedSocket();
+
+	// Queue a packet and send as much of the queue as possible. Takes a copy, as SFML keeps how much of a packet has been sent in the packet. Returns false if the socket has been closed.
+	bool send(sf::Packet packet);
+
+	// Send as much of the queue as possible. Call when the socket can send. Returns false if the socket has been closed.
+	bool flush();
+
+	// Receive a whole packet. Returns sf::Socket::NotReady until one has fully arrived.
+	sf::Socket::Status receive(sf::Packet& packet)
+	{
+		return socket->receive(packet);
+	};
+
+	// Close the socket once everything queued has been sent, or after a few seconds if it can't be.
+	void closeWhenSent();
+
+	// Close the socket straight away, dropping anything still queued.
+	// The connection is only marked as closed, and is disconnected when the buffered socket is destroyed. That way it can still be taken out of a socket poller first, which finds sockets by their handle.
+	void close();
+
+	// Getter functions.
+	// ----
+	sf::TcpSocket& getSocket()
+	{
+		return *socket;
+	};
+
+	sf::IpAddress getRemoteAddress() const
+	{
+		return socket->getRemoteAddress();
+	};
+
+	bool hasQueued() const
+	{
+		return !queued.empty();
+	};
+
+	bool isClosed() const
+	{
+		return closed;
+	};
+	// ----
+
+	// Most packets that can be waiting to send.
+	static const int maxQueued = 256;
+
+private:
+	// The socket is kept by pointer so the buffered socket can be moved into a container.
+	std::unique_ptr<sf::TcpSocket> socket;
+	std::deque<sf::Packet> queued;
+	bool closed;
+
+	// Whether to close once the queue is empty, and when to give up waiting for it to empty.
+	bool closing;
+	sf::Clock closingClock;
+	float closingTimeout;
+};
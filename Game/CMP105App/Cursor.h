@@ -1,5 +1,6 @@
 #pragma once
 #include "Framework/GameObject.h"
+#include "ResourceCache.h"
 
 // Class derived from GameObject
 class Cursor :
@@ -14,7 +15,7 @@ public:
 	void update(float dt) override;
 
 private:
-	// Texture of the mouse cursor
-	sf::Texture cursorTexture;
+	// Texture of the mouse cursor, shared by every cursor through the resource cache
+	std::shared_ptr<sf::Texture> cursorTexture;
 };
 
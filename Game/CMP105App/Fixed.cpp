@@ -0,0 +1,106 @@
+#include "Fixed.h"
+
+// ln(2) as a raw fixed point number.
+static const int64_t ln2 = 45426;
+
+Fixed sqrt(Fixed a)
+{
+	if (a.raw <= 0)
+	{
+		return Fixed();
+	}
+
+	// The square root of the raw value shifted up by the fractional bits is the raw square root. Worked out one bit at a time.
+	uint64_t value = (uint64_t)a.raw << Fixed::fractionBits;
+	uint64_t result = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+
+	while (bit > value)
+	{
+		bit >>= 2;
+	}
+
+	while (bit != 0)
+	{
+		if (value >= result + bit)
+		{
+			value -= result + bit;
+			result = (result >> 1) + bit;
+		}
+		else
+		{
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return Fixed::fromRaw((int64_t)result);
+}
+
+Fixed exp(Fixed a)
+{
+	// Too small to tell from 0, or too big to fit.
+	if (a.raw < -20 * Fixed::one)
+	{
+		return Fixed();
+	}
+	if (a.raw > 30 * Fixed::one)
+	{
+		a.raw = 30 * Fixed::one;
+	}
+
+	// Split into a power of 2 and a remainder between 0 and ln(2), so the series for the remainder converges quickly.
+	int64_t n = a.raw / ln2;
+	if (a.raw < 0 && a.raw % ln2 != 0)
+	{
+		n--;
+	}
+	Fixed r = Fixed::fromRaw(a.raw - n * ln2);
+
+	// e^r = 1 + r + r^2/2! + r^3/3! + ...
+	Fixed sum = 1;
+	Fixed term = 1;
+	for (int i = 1; i < 10; i++)
+	{
+		term = term * r / i;
+		sum += term;
+	}
+
+	return Fixed::fromRaw(n >= 0 ? sum.raw << n : sum.raw >> -n);
+}
+
+Fixed log(Fixed a)
+{
+	// Logs of 0 and below don't exist. Return a very large negative number.
+	if (a.raw <= 0)
+	{
+		return Fixed::fromRaw(-((int64_t)1 << 40));
+	}
+
+	// Scale into 1 to 2 by powers of 2.
+	int64_t e = 0;
+	int64_t m = a.raw;
+	while (m >= 2 * Fixed::one)
+	{
+		m >>= 1;
+		e++;
+	}
+	while (m < Fixed::one)
+	{
+		m <<= 1;
+		e--;
+	}
+
+	// ln(m) = 2(s + s^3/3 + s^5/5 + ...) where s = (m - 1) / (m + 1), which is under 1/3 here.
+	Fixed s = Fixed::fromRaw(m - Fixed::one) / Fixed::fromRaw(m + Fixed::one);
+	Fixed s2 = s * s;
+	Fixed power = s;
+	Fixed sum;
+	for (int i = 1; i < 12; i += 2)
+	{
+		sum += power / i;
+		power *= s2;
+	}
+
+	return Fixed::fromRaw(2 * sum.raw + e * ln2);
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <cmath>
+
+// Fixed point number class. Stores a number as a whole count of 1/65536ths (16 fractional bits) in a 64 bit integer, so arithmetic gives exactly the same result on every compiler and CPU.
+// Floats can differ between machines through compiler settings (such as fused multiply-adds) and maths library functions, so two clients can never be sure they simulate the same thing.
+// The 48 whole number bits leave room for squared speeds when solving the ball's path. sqrt, exp and log are worked out with integer arithmetic for the same reason.
+class Fixed
+{
+public:
+	// Number of fractional bits, and the raw value of 1.
+	static const int fractionBits = 16;
+	static const int64_t one = (int64_t)1 << fractionBits;
+
+	Fixed()
+	{
+		raw = 0;
+	};
+
+	Fixed(int i)
+	{
+		raw = (int64_t)i * one;
+	};
+
+	// Converting rounds to the nearest 1/65536th. Conversions are exact in IEEE arithmetic, so the same float always gives the same fixed point number.
+	Fixed(float f)
+	{
+		raw = (int64_t)std::floor((double)f * one + 0.5);
+	};
+
+	Fixed(double d)
+	{
+		raw = (int64_t)std::floor(d * one + 0.5);
+	};
+
+	// Make a fixed point number from its raw value.
+	static Fixed fromRaw(int64_t r)
+	{
+		Fixed f;
+		f.raw = r;
+		return f;
+	};
+
+	int64_t getRaw() const
+	{
+		return raw;
+	};
+
+	explicit operator float() const
+	{
+		return float((double)raw / one);
+	};
+
+	// Arithmetic operators. Multiplying and dividing shift by the fractional bits, rounding towards zero. Dividing by zero saturates to the largest number with the dividend's sign (or zero for zero over zero), rather than trapping, in the same way as a float gives infinity.
+	// ----
+	friend Fixed operator+(Fixed a, Fixed b)
+	{
+		return fromRaw(a.raw + b.raw);
+	};
+
+	friend Fixed operator-(Fixed a, Fixed b)
+	{
+		return fromRaw(a.raw - b.raw);
+	};
+
+	friend Fixed operator*(Fixed a, Fixed b)
+	{
+		return fromRaw(a.raw * b.raw / one);
+	};
+
+	friend Fixed operator/(Fixed a, Fixed b)
+	{
+		if (b.raw == 0)
+		{
+			return fromRaw(a.raw > 0 ? INT64_MAX : a.raw < 0 ? -INT64_MAX : 0);
+		}
+		return fromRaw(a.raw * one / b.raw);
+	};
+
+	Fixed operator-() const
+	{
+		return fromRaw(-raw);
+	};
+
+	Fixed& operator+=(Fixed b)
+	{
+		raw += b.raw;
+		return *this;
+	};
+
+	Fixed& operator-=(Fixed b)
+	{
+		raw -= b.raw;
+		return *this;
+	};
+
+	Fixed& operator*=(Fixed b)
+	{
+		*this = *this * b;
+		return *this;
+	};
+
+	Fixed& operator/=(Fixed b)
+	{
+		*this = *this / b;
+		return *this;
+	};
+	// ----
+
+	// Comparison operators.
+	// ----
+	friend bool operator==(Fixed a, Fixed b)
+	{
+		return a.raw == b.raw;
+	};
+
+	friend bool operator!=(Fixed a, Fixed b)
+	{
+		return a.raw != b.raw;
+	};
+
+	friend bool operator<(Fixed a, Fixed b)
+	{
+		return a.raw < b.raw;
+	};
+
+	friend bool operator>(Fixed a, Fixed b)
+	{
+		return a.raw > b.raw;
+	};
+
+	friend bool operator<=(Fixed a, Fixed b)
+	{
+		return a.raw <= b.raw;
+	};
+
+	friend bool operator>=(Fixed a, Fixed b)
+	{
+		return a.raw >= b.raw;
+	};
+	// ----
+
+	// Maths functions, found by argument lookup in the same way as the float versions in std.
+	// ----
+	friend Fixed abs(Fixed a)
+	{
+		return a.raw < 0 ? -a : a;
+	};
+
+	friend Fixed sqrt(Fixed a);
+	friend Fixed exp(Fixed a);
+	friend Fixed log(Fixed a);
+	// ----
+
+private:
+	int64_t raw;
+};
+
+// Number type used by the physics. Defining PHYSICS_FIXED_POINT for every client makes the physics use fixed point so that they all simulate exactly the same thing, at some cost in speed. The ReleaseFixed build configuration defines it, and builds CMP303-fixed.exe next to the float build so the two can be benchmarked against each other.
+// Players keep their position and velocity as floats in GameObject, so they are rounded to a float and back every step, and the ball's velocity is set from a float when kicked. Conversions are exact in IEEE arithmetic, so every machine still rounds the same way, but players are only as precise as a float.
+#ifdef PHYSICS_FIXED_POINT
+typedef Fixed Real;
+#else
+typedef float Real;
+#endif
+
+// Vector of the physics' number type.
+typedef sf::Vector2<Real> RealVector;
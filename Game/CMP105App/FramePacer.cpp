@@ -0,0 +1,118 @@
+#include "FramePacer.h"
+
+FramePacer::FramePacer()
+{
+	targetRate = 0;
+	tickLength = 0;
+	frameLength = 0;
+	period = 0;
+
+	nextFrame = 0;
+	lastFrame = -1;
+
+	// Sleeping usually wakes up within a couple of milliseconds.
+	spinTime = 2000;
+	minSpinTime = 500;
+
+	resetStats();
+}
+
+FramePacer::~FramePacer()
+{
+}
+
+void FramePacer::setTargetRate(float rate)
+{
+	targetRate = rate;
+	updatePeriod();
+}
+
+void FramePacer::setTickAlignment(float tick)
+{
+	tickLength = tick;
+	updatePeriod();
+}
+
+void FramePacer::updatePeriod()
+{
+	if (targetRate <= 0)
+	{
+		frameLength = 0;
+		period = 0;
+		return;
+	}
+
+	// Round to the nearest whole number of ticks, but at least one.
+	frameLength = 1.0 / targetRate;
+	if (tickLength > 0)
+	{
+		frameLength = std::max(1.0, std::round(frameLength / tickLength)) * tickLength;
+	}
+	period = sf::Int64(frameLength * 1000000 + 0.5);
+
+	nextFrame = clock.getElapsedTime().asMicroseconds();
+}
+
+float FramePacer::wait()
+{
+	sf::Int64 now = clock.getElapsedTime().asMicroseconds();
+	bool onTime = true;
+
+	if (period > 0)
+	{
+		// More than a frame behind, such as after loading or the window being dragged. Start again from now rather than rushing frames out to catch up.
+		if (now > nextFrame + period)
+		{
+			nextFrame = now;
+			onTime = false;
+		}
+
+		// Sleep until shortly before the frame is due.
+		sf::Int64 sleepTime = nextFrame - now - spinTime;
+		if (sleepTime > 0)
+		{
+			sf::sleep(sf::microseconds(sleepTime));
+
+			// Spin for longer straight away if sleeping woke up late, and for less a little at a time if it didn't.
+			sf::Int64 late = clock.getElapsedTime().asMicroseconds() - (now + sleepTime);
+			spinTime = std::max(std::max(late * 2, minSpinTime), spinTime - spinTime / 16);
+		}
+
+		// Spin for the rest.
+		while (clock.getElapsedTime().asMicroseconds() < nextFrame)
+		{
+		}
+
+		now = clock.getElapsedTime().asMicroseconds();
+		nextFrame += period;
+	}
+
+	// Measure the time between frames. The first frame has nothing to measure from.
+	if (lastFrame < 0)
+	{
+		lastFrame = now;
+		return 0;
+	}
+	sf::Int64 frameTime = now - lastFrame;
+	lastFrame = now;
+
+	double milliseconds = frameTime / 1000.0;
+	frameCount++;
+	double difference = milliseconds - frameTimeMean;
+	frameTimeMean += difference / frameCount;
+	frameTimeM2 += difference * (milliseconds - frameTimeMean);
+
+	// Aligned frames that are on time are exactly a whole number of ticks long.
+	if (tickLength > 0 && period > 0 && onTime)
+	{
+		return float(frameLength);
+	}
+	return float(frameTime) / 1000000;
+}
+
+void FramePacer::resetStats()
+{
+	frameCount = 0;
+	frameTimeMean = 0;
+	frameTimeM2 = 0;
+}
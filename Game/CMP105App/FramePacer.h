@@ -0,0 +1,83 @@
+#pragma once
+#include <SFML/System.hpp>
+#include <cmath>
+#include <algorithm>
+
+// Frame pacer class. Holds the game loop to a target frame rate, so it doesn't use a whole core running frames nobody sees, and so each frame's delta time is steady.
+// Waiting sleeps for most of the time, then spins for the last part, as sleeping can wake up a millisecond or more late. How late it wakes is measured, and the spinning time grows to cover it.
+// Frames can be aligned to ticks (such as the physics step), in which case the frame length is rounded to a whole number of ticks and frames that are on time are given exactly that delta time.
+// Every frame then runs the same number of physics steps, rather than some running one more and some one fewer, so input is always handled the same time before the frame showing it.
+// The time between frames is measured, and its mean and variance can be read to check how steady the pacing is.
+class FramePacer
+{
+public:
+	FramePacer();
+	~FramePacer();
+
+	// Frames per second to aim for. 0 doesn't limit the frame rate.
+	void setTargetRate(float rate);
+
+	// Length of the ticks to align frames to, in seconds. 0 turns alignment off.
+	void setTickAlignment(float tick);
+
+	// Wait until the next frame is due, and return its delta time in seconds.
+	float wait();
+
+	// Start measuring frame times again.
+	void resetStats();
+
+	// Getter functions for the measured time between frames, in milliseconds.
+	// ----
+	int getFrameCount()
+	{
+		return frameCount;
+	};
+
+	double getMeanFrameTime()
+	{
+		return frameTimeMean;
+	};
+
+	// Variance in milliseconds squared.
+	double getFrameTimeVariance()
+	{
+		return frameCount > 1 ? frameTimeM2 / (frameCount - 1) : 0;
+	};
+
+	double getFrameTimeDeviation()
+	{
+		return std::sqrt(getFrameTimeVariance());
+	};
+
+	// Length of each frame being aimed for, in seconds, after rounding to ticks. 0 if the frame rate isn't limited.
+	float getFrameLength()
+	{
+		return float(frameLength);
+	};
+	// ----
+
+private:
+	// Work out the frame length from the target rate and tick length.
+	void updatePeriod();
+
+	sf::Clock clock;
+
+	// Target rate and tick length set, and the frame length they give in seconds and in microseconds.
+	float targetRate;
+	float tickLength;
+	double frameLength;
+	sf::Int64 period;
+
+	// When the next frame is due and when the last frame started (-1 before the first), in microseconds since the pacer was created.
+	sf::Int64 nextFrame;
+	sf::Int64 lastFrame;
+
+	// How long before a frame is due to stop sleeping and start spinning, in microseconds.
+	sf::Int64 spinTime;
+	sf::Int64 minSpinTime;
+
+	// Time between frames, with the mean and sum of squared differences from it kept as frames are added (Welford's method).
+	int frameCount;
+	double frameTimeMean;
+	double frameTimeM2;
+};
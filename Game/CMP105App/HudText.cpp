@@ -0,0 +1,179 @@
+#include "HudText.h"
+
+HudText::HudText()
+{
+	font = nullptr;
+	characterSize = 30;
+	fillColour = sf::Color::White;
+	outlineColour = sf::Color::Black;
+	outlineThickness = 0;
+
+	shown[0] = '\0';
+	vertexCount = 0;
+	rebuildCount = 0;
+}
+
+HudText::~HudText()
+{
+}
+
+void HudText::setStyle(const sf::Text& text)
+{
+	font = text.getFont();
+	characterSize = text.getCharacterSize();
+	fillColour = text.getFillColor();
+	outlineColour = text.getOutlineColor();
+	outlineThickness = text.getOutlineThickness();
+
+	// Look up every glyph now. The font renders each one into its texture the first time it is asked for, so this is also where that happens.
+	for (int i = 0; font && i < characterCount; i++)
+	{
+		glyphs[i] = font->getGlyph(firstCharacter + i, characterSize, false);
+		outlineGlyphs[i] = font->getGlyph(firstCharacter + i, characterSize, false, outlineThickness);
+	}
+
+	// Always rebuild, as the style has changed.
+	std::string string = text.getString();
+	std::strncpy(shown, string.c_str(), maxLength);
+	shown[maxLength] = '\0';
+	rebuild();
+}
+
+void HudText::setString(const char* string)
+{
+	// Nothing to do if the string hasn't changed, which is most frames.
+	if (std::strncmp(shown, string, maxLength) == 0)
+	{
+		return;
+	}
+
+	std::strncpy(shown, string, maxLength);
+	shown[maxLength] = '\0';
+	rebuild();
+}
+
+void HudText::rebuild()
+{
+	rebuildCount++;
+
+	// Six vertices for each glyph's outline and fill. The array only grows, so it stops allocating once the longest string has been shown.
+	int length = int(std::strlen(shown));
+	int needed = length * (outlineThickness != 0 ? 12 : 6);
+	if (needed > int(vertices.getVertexCount()))
+	{
+		vertices.resize(needed);
+	}
+	vertexCount = 0;
+
+	if (!font || length == 0)
+	{
+		bounds = sf::FloatRect();
+		return;
+	}
+
+	// Lay out glyphs along the baseline in the same way as sf::Text, finding the bounds as they are placed.
+	float x = 0;
+	float y = float(characterSize);
+	float minX = float(characterSize);
+	float minY = float(characterSize);
+	float maxX = 0;
+	float maxY = 0;
+	int glyphCount = 0;
+	sf::Uint32 previous = 0;
+
+	// Outline glyphs go first so they are drawn behind the fill.
+	int fillStart = outlineThickness != 0 ? length * 6 : 0;
+
+	for (int i = 0; i < length; i++)
+	{
+		sf::Uint32 character = (unsigned char)shown[i];
+		if (character < firstCharacter || character >= firstCharacter + characterCount)
+		{
+			continue;
+		}
+
+		x += font->getKerning(previous, character, characterSize);
+		previous = character;
+
+		const sf::Glyph& glyph = glyphs[character - firstCharacter];
+
+		if (character == ' ')
+		{
+			minX = std::min(minX, x);
+			minY = std::min(minY, y);
+			x += glyph.advance;
+			maxX = std::max(maxX, x);
+			maxY = std::max(maxY, y);
+			continue;
+		}
+
+		if (outlineThickness != 0)
+		{
+			addGlyph(glyphCount * 6, sf::Vector2f(x, y), outlineGlyphs[character - firstCharacter], outlineColour, outlineThickness);
+		}
+		addGlyph(fillStart + glyphCount * 6, sf::Vector2f(x, y), glyph, fillColour, 0);
+		glyphCount++;
+
+		minX = std::min(minX, x + glyph.bounds.left);
+		maxX = std::max(maxX, x + glyph.bounds.left + glyph.bounds.width);
+		minY = std::min(minY, y + glyph.bounds.top);
+		maxY = std::max(maxY, y + glyph.bounds.top + glyph.bounds.height);
+
+		x += glyph.advance;
+	}
+
+	// Spaces don't have quads, so close the gap between the outline and fill quads.
+	if (outlineThickness != 0 && glyphCount < length)
+	{
+		for (int i = 0; i < glyphCount * 6; i++)
+		{
+			vertices[glyphCount * 6 + i] = vertices[fillStart + i];
+		}
+	}
+	vertexCount = glyphCount * (outlineThickness != 0 ? 12 : 6);
+
+	// The outline makes the text bigger on every side.
+	if (outlineThickness != 0)
+	{
+		float outline = std::abs(std::ceil(outlineThickness));
+		minX -= outline;
+		maxX += outline;
+		minY -= outline;
+		maxY += outline;
+	}
+	bounds = sf::FloatRect(minX, minY, maxX - minX, maxY - minY);
+}
+
+void HudText::addGlyph(int vertex, sf::Vector2f position, const sf::Glyph& glyph, sf::Color colour, float offset)
+{
+	// A pixel of padding round each glyph, as sf::Text uses, so smoothing doesn't cut off its edges.
+	float padding = 1;
+	float left = position.x + glyph.bounds.left - padding - offset;
+	float top = position.y + glyph.bounds.top - padding - offset;
+	float right = position.x + glyph.bounds.left + glyph.bounds.width + padding - offset;
+	float bottom = position.y + glyph.bounds.top + glyph.bounds.height + padding - offset;
+
+	float u1 = float(glyph.textureRect.left) - padding;
+	float v1 = float(glyph.textureRect.top) - padding;
+	float u2 = float(glyph.textureRect.left + glyph.textureRect.width) + padding;
+	float v2 = float(glyph.textureRect.top + glyph.textureRect.height) + padding;
+
+	vertices[vertex] = sf::Vertex(sf::Vector2f(left, top), colour, sf::Vector2f(u1, v1));
+	vertices[vertex + 1] = sf::Vertex(sf::Vector2f(right, top), colour, sf::Vector2f(u2, v1));
+	vertices[vertex + 2] = sf::Vertex(sf::Vector2f(left, bottom), colour, sf::Vector2f(u1, v2));
+	vertices[vertex + 3] = sf::Vertex(sf::Vector2f(left, bottom), colour, sf::Vector2f(u1, v2));
+	vertices[vertex + 4] = sf::Vertex(sf::Vector2f(right, top), colour, sf::Vector2f(u2, v1));
+	vertices[vertex + 5] = sf::Vertex(sf::Vector2f(right, bottom), colour, sf::Vector2f(u2, v2));
+}
+
+void HudText::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	if (!font || vertexCount == 0)
+	{
+		return;
+	}
+
+	states.transform *= getTransform();
+	states.texture = &font->getTexture(characterSize);
+	target.draw(&vertices[0], vertexCount, sf::Triangles, states);
+}
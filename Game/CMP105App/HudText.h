@@ -0,0 +1,91 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+// HUD text class. Draws text that is set every frame but rarely changes, such as the ping, score and timer, without rebuilding it or allocating memory when the string is the same as last frame.
+// The glyphs of every printable ASCII character are looked up once when the style is set, like a bitmap font, so building the quads for a new string (the timer changes most frames) only reads a table.
+// The string is kept in a fixed size buffer and the quads in a vertex array that only grows, so once it has shown its longest string, setting the text never allocates.
+// Drawn the same way as sf::Text, with the outline behind the fill, so it looks the same. Only the first maxLength characters are shown, and characters outside printable ASCII are skipped.
+class HudText : public sf::Drawable, public sf::Transformable
+{
+public:
+	HudText();
+	~HudText();
+
+	// Take the font, character size and colours from a text object, and show its string.
+	void setStyle(const sf::Text& text);
+
+	// Show a string. Does nothing if it is already being shown. Strings should be formatted into a buffer (with snprintf), as building a std::string each frame allocates.
+	void setString(const char* string);
+	void setString(const std::string& string)
+	{
+		setString(string.c_str());
+	};
+
+	// Getter functions.
+	// ----
+	const char* getString()
+	{
+		return shown;
+	};
+
+	// Bounds of the text before it is transformed, in the same way as sf::Text.
+	sf::FloatRect getLocalBounds()
+	{
+		return bounds;
+	};
+
+	sf::FloatRect getGlobalBounds()
+	{
+		return getTransform().transformRect(bounds);
+	};
+
+	// How many times the quads have been rebuilt, for checking that unchanged strings are skipped.
+	int getRebuildCount()
+	{
+		return rebuildCount;
+	};
+
+	// Draw calls made drawing it: one for the outline and fill together, or none if there is nothing to show.
+	int getDrawCalls() const
+	{
+		return font && vertexCount > 0 ? 1 : 0;
+	};
+	// ----
+
+	static const int maxLength = 79;
+
+private:
+	// Draw the quads with the font's glyph texture.
+	void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+
+	// Build the quads for the string being shown.
+	void rebuild();
+
+	// Add the two triangles of one glyph at a position on the baseline.
+	void addGlyph(int vertex, sf::Vector2f position, const sf::Glyph& glyph, sf::Color colour, float offset);
+
+	// Style taken from setStyle().
+	const sf::Font* font;
+	unsigned int characterSize;
+	sf::Color fillColour;
+	sf::Color outlineColour;
+	float outlineThickness;
+
+	// Glyphs of the printable ASCII characters (space to ~), filled and outlined.
+	static const int firstCharacter = 32;
+	static const int characterCount = 95;
+	sf::Glyph glyphs[characterCount];
+	sf::Glyph outlineGlyphs[characterCount];
+
+	// The string being shown, and its quads: every outline glyph, then every fill glyph.
+	char shown[maxLength + 1];
+	sf::VertexArray vertices;
+	int vertexCount;
+	sf::FloatRect bounds;
+	int rebuildCount;
+};
@@ -0,0 +1,242 @@
+#include "LatencyProbe.h"
+
+LatencyProbe::LatencyProbe()
+{
+	enabled = false;
+	step = 0;
+	newestRead = -1;
+
+	// Nothing is held to begin with.
+	held.assign(sf::Keyboard::KeyCount + sf::Mouse::ButtonCount, false);
+	unread.assign(held.size(), -1);
+
+	// Set up empty histograms.
+	Histogram empty;
+	empty.buckets.assign(bucketCount, 0);
+	empty.count = 0;
+	empty.total = 0;
+	empty.slowest = 0;
+	localToStep = empty;
+	localToPhoton = empty;
+	remoteToPhoton = empty;
+}
+
+LatencyProbe::~LatencyProbe()
+{
+}
+
+LatencyProbe& LatencyProbe::getShared()
+{
+	static LatencyProbe probe;
+	return probe;
+}
+
+void LatencyProbe::inputPressed(int input)
+{
+	if (!enabled || input < 0 || input >= held.size())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!held[input])
+	{
+		held[input] = true;
+		unread[input] = now();
+	}
+}
+
+void LatencyProbe::inputReleased(int input)
+{
+	if (!enabled || input < 0 || input >= held.size())
+	{
+		return;
+	}
+
+	// A press released before gameplay read it was never acted on.
+	std::lock_guard<std::mutex> lock(mutex);
+	held[input] = false;
+	unread[input] = -1;
+}
+
+void LatencyProbe::inputRead(int input)
+{
+	if (!enabled || input < 0 || input >= held.size())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (unread[input] >= 0)
+	{
+		pending.push_back(unread[input]);
+		unread[input] = -1;
+	}
+}
+
+void LatencyProbe::discardPending()
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	pending.clear();
+	std::fill(unread.begin(), unread.end(), -1);
+}
+
+void LatencyProbe::stepStarted()
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	step++;
+
+	// Every press gameplay has read so far was read before this step, so this is the first step it can change.
+	sf::Int64 time = now();
+	for (int i = 0; i < pending.size(); i++)
+	{
+		Press press = { pending[i], step, false };
+		inFlight.push_back(press);
+		add(localToStep, time - pending[i]);
+		newestRead = std::max(newestRead, pending[i]);
+	}
+	pending.clear();
+}
+
+sf::Int32 LatencyProbe::takeInputAge()
+{
+	if (!enabled)
+	{
+		return -1;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (newestRead < 0)
+	{
+		return -1;
+	}
+
+	sf::Int64 age = now() - newestRead;
+	newestRead = -1;
+	return sf::Int32(std::min<sf::Int64>(age, 0x7fffffff));
+}
+
+void LatencyProbe::remoteInputReceived(sf::Int32 age, float transit)
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	// Work out when the press happened on this client's clock. The position has already been applied, so the next step's frame shows it.
+	std::lock_guard<std::mutex> lock(mutex);
+	Press press = { now() - age - sf::Int64(transit * 1000), step + 1, true };
+	inFlight.push_back(press);
+}
+
+void LatencyProbe::framePresented(sf::Uint64 frameStep)
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	// Finish every press read by a step this frame was recorded after. Presses in dropped frames wait for the next frame that is presented.
+	std::lock_guard<std::mutex> lock(mutex);
+	sf::Int64 time = now();
+	for (int i = 0; i < inFlight.size(); i++)
+	{
+		if (inFlight[i].step <= frameStep)
+		{
+			add(inFlight[i].remote ? remoteToPhoton : localToPhoton, time - inFlight[i].time);
+		}
+	}
+	inFlight.erase(std::remove_if(inFlight.begin(), inFlight.end(), [frameStep](const Press& p) { return p.step <= frameStep; }), inFlight.end());
+}
+
+void LatencyProbe::add(Histogram& histogram, sf::Int64 latency)
+{
+	int bucket = int(std::min<sf::Int64>(latency / 1000, bucketCount - 1));
+	histogram.buckets[std::max(bucket, 0)]++;
+	histogram.count++;
+	histogram.total += latency;
+	histogram.slowest = std::max(histogram.slowest, latency);
+}
+
+void LatencyProbe::report()
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	print("Input to physics step", localToStep);
+	print("Input to photon", localToPhoton);
+	print("Remote input to photon", remoteToPhoton);
+}
+
+void LatencyProbe::print(const char* name, const Histogram& histogram)
+{
+	if (histogram.count == 0)
+	{
+		std::cout << name << ": no presses measured.\n";
+		return;
+	}
+
+	// Percentiles are the top of the bucket they fall in.
+	const float percentiles[3] = { 0.5f, 0.9f, 0.99f };
+	int under[3] = { 0, 0, 0 };
+	int counted = 0;
+	int p = 0;
+	for (int i = 0; i < bucketCount && p < 3; i++)
+	{
+		counted += histogram.buckets[i];
+		while (p < 3 && counted >= percentiles[p] * histogram.count)
+		{
+			under[p++] = i + 1;
+		}
+	}
+
+	std::cout << name << ": " << histogram.count << " presses, mean " << float(histogram.total) / histogram.count / 1000 << "ms, 50% under " << under[0] << "ms, 90% under " << under[1] << "ms, 99% under " << under[2] << "ms, slowest " << float(histogram.slowest) / 1000 << "ms.\n";
+
+	// Group buckets into fives, and draw a bar for each group between the fastest and slowest, scaled so the largest is 50 characters.
+	const int groupSize = 5;
+	const int groupCount = (bucketCount + groupSize - 1) / groupSize;
+	std::vector<int> groups(groupCount, 0);
+	for (int i = 0; i < bucketCount; i++)
+	{
+		groups[i / groupSize] += histogram.buckets[i];
+	}
+
+	int first = 0;
+	int last = groupCount - 1;
+	while (groups[first] == 0)
+	{
+		first++;
+	}
+	while (groups[last] == 0)
+	{
+		last--;
+	}
+	int largest = *std::max_element(groups.begin(), groups.end());
+
+	for (int i = first; i <= last; i++)
+	{
+		int start = i * groupSize;
+		if (i == groupCount - 1)
+		{
+			std::cout << "  " << start << "ms+";
+		}
+		else
+		{
+			std::cout << "  " << start << "-" << start + groupSize << "ms";
+		}
+		std::cout << "\t" << std::string(groups[i] * 50 / largest, '#') << " " << groups[i] << "\n";
+	}
+}
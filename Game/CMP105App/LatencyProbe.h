@@ -0,0 +1,138 @@
+#pragma once
+#include <SFML/System.hpp>
+#include <SFML/Window/Keyboard.hpp>
+#include <SFML/Window/Mouse.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <algorithm>
+
+// Latency probe class. Measures input to photon latency: how long it takes from a key press or click reaching the game until a frame showing what it did is on screen.
+// Each press is timestamped when its event is handled, tagged with the physics step that runs after gameplay has read it, and finished when the render thread presents a frame recorded after that step.
+// Which keys and buttons are physically held is tracked here rather than taken from Input, as gameplay marks keys as up while they are still held, which would make key repeats look like new presses. Presses gameplay never reads aren't counted.
+// The other client's presses are measured too. Their position packets carry how long before sending the press was read, timed on their own clock so the two clocks don't have to agree.
+// Half the ping is added for the packet's trip, and the rest is timed from receiving it until a frame showing it is presented.
+// Results are kept in histograms with a bucket for each millisecond. Used from both the main and render threads, so each function locks. Does nothing until enabled.
+class LatencyProbe
+{
+public:
+	LatencyProbe();
+	~LatencyProbe();
+
+	// The probe used by the whole game.
+	static LatencyProbe& getShared();
+
+	// Inputs are numbered with the keyboard's keys first, followed by the mouse buttons.
+	// ----
+	static int key(sf::Keyboard::Key k)
+	{
+		return int(k);
+	};
+
+	static int mouseButton(sf::Mouse::Button b)
+	{
+		return sf::Keyboard::KeyCount + int(b);
+	};
+	// ----
+
+	// A key or mouse button has gone down or up. Going down while already held (a key repeat) isn't a new press.
+	void inputPressed(int input);
+	void inputReleased(int input);
+
+	// Gameplay has acted on an input being held. The first read of each press makes it wait for the next physics step.
+	void inputRead(int input);
+
+	// Presses made outside a match are never read by a physics step, so they are dropped rather than counted against the next match.
+	void discardPending();
+
+	// A physics step is starting. Presses waiting to be read are tagged with it.
+	void stepStarted();
+
+	// How long ago, in microseconds, the newest press read by a step since the last call was made. -1 if there hasn't been one. Sent with the controlled player's position.
+	sf::Int32 takeInputAge();
+
+	// The other client's position packet carried a press made the given number of microseconds before it was sent. Transit is the time the packet took to arrive, in milliseconds.
+	void remoteInputReceived(sf::Int32 age, float transit);
+
+	// The render thread has presented a frame recorded after the given step.
+	void framePresented(sf::Uint64 step);
+
+	// Print the histograms.
+	void report();
+
+	// Getter and setter functions.
+	// ----
+	void setEnabled(bool e)
+	{
+		enabled = e;
+	};
+
+	bool getEnabled()
+	{
+		return enabled;
+	};
+
+	// The last physics step started. Frames are tagged with this when they are recorded.
+	sf::Uint64 getStep()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return step;
+	};
+	// ----
+
+	// Number of one millisecond buckets in each histogram. Anything slower goes in the last.
+	static const int bucketCount = 250;
+
+private:
+	// Latencies, counted into one millisecond buckets, with their total and slowest in microseconds.
+	struct Histogram
+	{
+		std::vector<int> buckets;
+		int count;
+		sf::Int64 total;
+		sf::Int64 slowest;
+	};
+
+	// A press that has been read by a step, waiting for a frame after that step to be presented. Time is when it was pressed on this client's clock.
+	struct Press
+	{
+		sf::Int64 time;
+		sf::Uint64 step;
+		bool remote;
+	};
+
+	// Add a latency in microseconds to a histogram.
+	void add(Histogram& histogram, sf::Int64 latency);
+
+	// Print one histogram, with its count, mean, percentiles and a bar for each five milliseconds.
+	void print(const char* name, const Histogram& histogram);
+
+	// Microseconds since the probe was created.
+	sf::Int64 now()
+	{
+		return clock.getElapsedTime().asMicroseconds();
+	};
+
+	bool enabled;
+	sf::Clock clock;
+
+	// Which inputs are held, and when each was pressed if gameplay hasn't read the press yet (-1 if not).
+	std::vector<bool> held;
+	std::vector<sf::Int64> unread;
+
+	// Presses that haven't been read by a step yet, and those waiting for a frame to be presented.
+	std::vector<sf::Int64> pending;
+	std::vector<Press> inFlight;
+
+	// Physics steps started, and when the newest press read since the last position was sent was made (-1 if none).
+	sf::Uint64 step;
+	sf::Int64 newestRead;
+
+	// Time from pressing to the step that reads it, from pressing to presenting, and the same for the other client's presses.
+	Histogram localToStep;
+	Histogram localToPhoton;
+	Histogram remoteToPhoton;
+
+	std::mutex mutex;
+};
@@ -1,6 +1,6 @@
 #include "Level.h"
 
-Level::Level(sf::RenderWindow* hwnd, Input* in, NetworkManager* nm)
+Level::Level(sf::RenderWindow* hwnd, Input* in, NetworkManager* nm) : renderer(hwnd)
 {
 	window = hwnd;
 	input = in;
@@ -31,6 +31,10 @@ void Level::handleInput(float dt)
 	{
 	case State::MENU:
 		mainMenu.handleInput(dt);
+		if (mainMenu.getQuit())
+		{
+			close();
+		}
 		break;
 	case State::LEVEL:
 		objectManager.handleInput(dt);
@@ -44,12 +48,31 @@ void Level::handleInput(float dt)
 // Update game objects
 void Level::update(float dt)
 {
+	// Updating can measure text, which uses its font, so hold the font lock in case the render thread is drawing text.
+	std::lock_guard<std::mutex> fontLock(ResourceCache::getShared().getFontMutex());
+
+	// Upload assets that have finished loading in the background. Everything past the main menu needs every asset, so wait for any left.
+	if (gameState.getCurrentState() == State::MENU)
+	{
+		AssetLoader::getShared().update();
+	}
+	else
+	{
+		AssetLoader::getShared().finish();
+	}
+
 	// If no music is playing, play music.
 	if (audio.getMusic()->getStatus() == sf::Music::Status::Stopped)
 	{
 		audio.playMusicbyName("music");
 	}
 
+	// Presses outside a match aren't read by the physics, so the latency probe shouldn't wait for them.
+	if (gameState.getCurrentState() != State::LEVEL)
+	{
+		LatencyProbe::getShared().discardPending();
+	}
+
 	// Switch statement to control what objects are updated based on the current game state.
 	switch (gameState.getCurrentState())
 	{
@@ -69,33 +92,35 @@ void Level::update(float dt)
 // Render level
 void Level::render()
 {
-	beginDraw();
+	// Recording text measures it, so hold the font lock here too.
+	std::lock_guard<std::mutex> fontLock(ResourceCache::getShared().getFontMutex());
+
+	// Record the frame into a snapshot. Background colour set to blue.
+	RenderSnapshot& snapshot = renderer.getSnapshot();
+	snapshot.clear(sf::Color::Blue, sf::View(sf::FloatRect(0, 0, window->getSize().x, window->getSize().y)));
+	snapshot.setStep(LatencyProbe::getShared().getStep());
 
 	// Switch statement to control what objects are rendered based on the current game state.
 	switch (gameState.getCurrentState())
 	{
 	case State::MENU:
-		mainMenu.render();
+		mainMenu.render(snapshot);
 		break;
 	case State::LEVEL:
-		objectManager.render();
+		objectManager.render(snapshot);
 		break;
 	case State::LOBBY:
-		lobby.render();
+		lobby.render(snapshot);
 		break;
 	}
 
-	endDraw();
+	// Hand the frame to the render thread, which draws it and swaps it to the screen.
+	renderer.publish();
 }
 
-// Begins rendering to the back buffer. Background colour set to blue.
-void Level::beginDraw()
+void Level::close()
 {
-	window->clear(sf::Color::Blue); 
+	// The render thread has to let go of the window before it can be closed.
+	renderer.stop();
+	window->close();
 }
-
-// Ends rendering to the back buffer, and swaps buffer to the screen.
-void Level::endDraw()
-{
-	window->display();
-}
\ No newline at end of file
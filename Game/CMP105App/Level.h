@@ -10,6 +10,8 @@
 #include "MainMenu.h"
 #include "ObjectManager.h"
 #include "NetworkManager.h"
+#include "AssetLoader.h"
+#include "RenderThread.h"
 
 class Level{
 public:
@@ -20,11 +22,29 @@ public:
 	void update(float dt);
 	void render();
 
-private:
-	// Default functions for rendering to the screen.
-	void beginDraw();
-	void endDraw();
+	// Stop the render thread and close the window.
+	void close();
+
+	// Length of a physics step, which the frame pacer can align frames to.
+	float getPhysicsStep()
+	{
+		return objectManager.getPhysicsStep();
+	};
+
+	// Frames the render thread has drawn, and frames replaced by newer ones before it could draw them.
+	// ----
+	int getFramesPresented()
+	{
+		return renderer.getFramesPresented();
+	};
 
+	int getFramesDropped()
+	{
+		return renderer.getFramesDropped();
+	};
+	// ----
+
+private:
 	// Objects for each of the manager classes.
 	sf::RenderWindow* window;
 	Input* input;
@@ -34,4 +54,7 @@ private:
 	MainMenu mainMenu;
 	ObjectManager objectManager;
 	NetworkManager* networkManager;
+
+	// Draws each frame on its own thread. Started last, once everything else has loaded using the window's context.
+	RenderThread renderer;
 };
\ No newline at end of file
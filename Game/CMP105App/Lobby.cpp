@@ -2,28 +2,37 @@
 
 Lobby::Lobby()
 {
-	// Load font
-	if (!font.loadFromFile("font/arial.ttf"))
-	{
-		std::cout << "Error loading font.\n";
-	}
+	// Get font from the shared cache, which only loads it the first time.
+	font = ResourceCache::getShared().getFont("font/arial.ttf");
 
-	// Load textures
-	messi.loadFromFile("gfx/messi.png");
-	ronaldo.loadFromFile("gfx/ronaldo.png");
-	kirby.loadFromFile("gfx/kirby.png");
-	miedema.loadFromFile("gfx/miedema.png");
+	// Load textures in the background, so the main menu doesn't wait for them. The lobby waits for them to finish before it is shown.
+	// Each preview starts on the first texture it is given. The right preview is flipped to face the left one.
+	AssetLoader& loader = AssetLoader::getShared();
+	loader.loadTexture("gfx/messi.png", [this](std::shared_ptr<sf::Texture> texture)
+	{
+		messi = texture;
+		leftPlayerPreview.setTexture(*messi);
+	});
+	loader.loadTexture("gfx/ronaldo.png", [this](std::shared_ptr<sf::Texture> texture)
+	{
+		ronaldo = texture;
+		rightPlayerPreview.setTexture(*ronaldo);
+		sf::IntRect textureRect = rightPlayerPreview.getTextureRect();
+		rightPlayerPreview.setTextureRect(sf::IntRect(textureRect.left + textureRect.width, textureRect.top, -textureRect.width, textureRect.height));
+	});
+	loader.loadTexture("gfx/kirby.png", [this](std::shared_ptr<sf::Texture> texture)
+	{
+		kirby = texture;
+	});
+	loader.loadTexture("gfx/miedema.png", [this](std::shared_ptr<sf::Texture> texture)
+	{
+		miedema = texture;
+	});
 
 	// Set previews
-	leftPlayerPreview.setTexture(messi);
 	leftPlayerPreview.setScale(sf::Vector2f(0.75, 0.75));
-	rightPlayerPreview.setTexture(ronaldo);
 	rightPlayerPreview.setScale(sf::Vector2f(0.75, 0.75));
 
-	// Flip right preview
-	sf::IntRect textureRect = rightPlayerPreview.getTextureRect();
-	rightPlayerPreview.setTextureRect(sf::IntRect(textureRect.left + textureRect.width, textureRect.top, -textureRect.width, textureRect.height));
-	
 
 	// Set colours
 	notSelectedColour = sf::Color::White;
@@ -49,7 +58,7 @@ Lobby::Lobby()
 	// Setup buttons
 	// ----
 	sf::Text buttonText;
-	buttonText.setFont(font);
+	buttonText.setFont(*font);
 	buttonText.setCharacterSize(80);
 	buttonText.setFillColor(notSelectedColour);
 	buttonText.setOutlineColor(sf::Color::Black);
@@ -66,6 +75,9 @@ Lobby::Lobby()
 	buttonText.setString("CONNECT");
 	connectButton.setText(buttonText);
 
+	buttonText.setString("FIND MATCH");
+	findMatchButton.setText(buttonText);
+
 	buttonText.setString(" < ");
 	characterBack.setText(buttonText);
 
@@ -73,43 +85,43 @@ Lobby::Lobby()
 	characterForward.setText(buttonText);
 
 	sf::Text infoText;
-	infoText.setFont(font);
+	infoText.setFont(*font);
 	infoText.setCharacterSize(20);
 	infoText.setFillColor(sf::Color::White);
 	infoText.setOutlineColor(sf::Color::Black);
 	infoText.setOutlineThickness(1);
 
-	previousScore = infoText;
+	previousScore.setStyle(infoText);
 
 	infoText.setString("Host IP: 0.0.0.0");
-	hostIP = infoText;
+	hostIP.setStyle(infoText);
 
 	infoText.setString("Local IP: 0.0.0.0");
-	localIP = infoText;
+	localIP.setStyle(infoText);
 
 	infoText.setString("Host Port: 0");
-	hostPort = infoText;
+	hostPort.setStyle(infoText);
 
 	infoText.setString("Host Ready: NO");
-	hostReady = infoText;
+	hostReady.setStyle(infoText);
 
 	infoText.setString("Client IP: N/A");
-	clientIP = infoText;
+	clientIP.setStyle(infoText);
 
 	infoText.setString("Client Port: N/A");
-	clientPort = infoText;
+	clientPort.setStyle(infoText);
 
 	infoText.setString("Client Ready: NO");
-	clientReady = infoText;
+	clientReady.setStyle(infoText);
 
 	infoText.setString("Ping: N/A");
-	ping = infoText;
+	ping.setStyle(infoText);
 
 	infoText.setString("Connection status: Waiting for client to connect");
-	connectionStatus = infoText;
+	connectionStatus.setStyle(infoText);
 
 	infoText.setString("Ready Countdown: X");
-	timer = infoText;
+	timer.setStyle(infoText);
 
 	infoText.setString("Host IP Address: ");
 	connectIP = infoText;
@@ -123,13 +135,19 @@ Lobby::Lobby()
 	textBoxIP.setText(infoText);
 	textBoxPort.setText(infoText);
 
-	connectionFailedText.setFont(font);
+	connectionFailedText.setFont(*font);
 	connectionFailedText.setCharacterSize(20);
 	connectionFailedText.setFillColor(sf::Color::Red);
 	connectionFailedText.setOutlineColor(sf::Color::Black);
 	connectionFailedText.setOutlineThickness(1);
 	connectionFailedText.setString("Connection failed :(");
 
+	matchmakingText = connectionFailedText;
+	matchmakingText.setFillColor(sf::Color::White);
+	matchmakingText.setString("Searching for a match...");
+
+	connectingText.setStyle(matchmakingText);
+
 	textBoxSize = sf::Vector2f(200, 20);
 	// ----
 }
@@ -214,6 +232,20 @@ void Lobby::handleInput(float dt)
 					connect();
 				}
 			}
+			else if (networkManager->getMatchmakerConfigured() && Collision::checkBoundingBox(&cursor, &findMatchButton)) // Sets current selection to find match when hovering over the button. Asks the matchmaker for a match if the button is pressed.
+			{
+				currentSelection = Selection::FIND_MATCH;
+
+				if (input->isMouseLDown())
+				{
+					input->setMouseLDown(false);
+
+					if (!networkManager->getMatchmaking())
+					{
+						connectionFailed = !networkManager->findMatch();
+					}
+				}
+			}
 		}
 	}
 
@@ -414,46 +446,53 @@ void Lobby::handleInput(float dt)
 
 void Lobby::update(float dt)
 {
-	sf::View view(sf::FloatRect(0, 0, window->getSize().x, window->getSize().y));
-	window->setView(view);
-
 	// Update cursor position.
 	cursor.update(dt);
 
 	// Get connection status from network manager.
 	clientConnected = networkManager->getConnected();
 
+	// If the connection attempt failed, set statuses and reset text input.
+	if (!isHost && networkManager->getConnectState() == NetworkManager::CONNECT_FAILED)
+	{
+		networkManager->resetConnectState();
+		connectionFailed = true;
+		inputIP = "";
+		inputPort = "";
+		textBoxSelection = 0;
+	}
+
 	// Set textures for host and client character previews.
 	// ----
 	switch (hostChar)
 	{
 	case MESSI:
-		leftPlayerPreview.setTexture(messi);
+		leftPlayerPreview.setTexture(*messi);
 		break;
 	case RONALDO:
-		leftPlayerPreview.setTexture(ronaldo);
+		leftPlayerPreview.setTexture(*ronaldo);
 		break;
 	case KIRBY:
-		leftPlayerPreview.setTexture(kirby);
+		leftPlayerPreview.setTexture(*kirby);
 		break;
 	case MIEDEMA:
-		leftPlayerPreview.setTexture(miedema);
+		leftPlayerPreview.setTexture(*miedema);
 		break;
 	}
 
 	switch (clientChar)
 	{
 	case MESSI:
-		rightPlayerPreview.setTexture(messi);
+		rightPlayerPreview.setTexture(*messi);
 		break;
 	case RONALDO:
-		rightPlayerPreview.setTexture(ronaldo);
+		rightPlayerPreview.setTexture(*ronaldo);
 		break;
 	case KIRBY:
-		rightPlayerPreview.setTexture(kirby);
+		rightPlayerPreview.setTexture(*kirby);
 		break;
 	case MIEDEMA:
-		rightPlayerPreview.setTexture(miedema);
+		rightPlayerPreview.setTexture(*miedema);
 		break;
 	}
 	// ----
@@ -489,15 +528,15 @@ void Lobby::update(float dt)
 	setupButtonsText();
 }
 
-void Lobby::render()
+void Lobby::render(RenderSnapshot& snapshot)
 {
 	if (isHost) // Draw local IP if host. Draw back button, and ready button if there is a client connected.
 	{
-		window->draw(localIP);
-		window->draw(backButton.getText());
+		snapshot.draw(localIP);
+		snapshot.draw(backButton.getText());
 		if (clientConnected)
 		{
-			window->draw(readyButton.getText());
+			snapshot.draw(readyButton.getText());
 		}
 		
 	}
@@ -505,58 +544,73 @@ void Lobby::render()
 	{
 		if (clientConnected)
 		{
-			window->draw(backButton.getText());
+			snapshot.draw(backButton.getText());
 
-			window->draw(readyButton.getText());
+			snapshot.draw(readyButton.getText());
 		}
 		else
 		{
-			window->draw(backButton.getText());
+			snapshot.draw(backButton.getText());
 
-			window->draw(connectButton.getText());
+			snapshot.draw(connectButton.getText());
+
+			if (networkManager->getMatchmakerConfigured())
+			{
+				snapshot.draw(findMatchButton.getText());
+			}
 		}
 	}
 
 	// Render status texts
 	if (isHost || clientConnected) // Draw the network status text objects, and character preview objects.
 	{
-		window->draw(hostIP);
-		window->draw(hostPort);
-		window->draw(hostReady);
-		window->draw(clientIP);
-		window->draw(clientPort);
-		window->draw(clientReady);
-		window->draw(ping);
-		window->draw(connectionStatus);
-		window->draw(timer);
+		snapshot.draw(hostIP);
+		snapshot.draw(hostPort);
+		snapshot.draw(hostReady);
+		snapshot.draw(clientIP);
+		snapshot.draw(clientPort);
+		snapshot.draw(clientReady);
+		snapshot.draw(ping);
+		snapshot.draw(connectionStatus);
+		snapshot.draw(timer);
 
 		if (clientConnected)
 		{
-			window->draw(leftPlayerPreview);
-			window->draw(rightPlayerPreview);
-			window->draw(characterBack);
-			window->draw(characterBack.getText());
-			window->draw(characterForward);
-			window->draw(characterForward.getText());
+			snapshot.draw(leftPlayerPreview);
+			snapshot.draw(rightPlayerPreview);
+			snapshot.draw(characterBack);
+			snapshot.draw(characterBack.getText());
+			snapshot.draw(characterForward);
+			snapshot.draw(characterForward.getText());
 		}
 		
 		if (postMatch == true) // Draw previous score if in a post match lobby.
 		{
-			window->draw(previousScore);
+			snapshot.draw(previousScore);
 		}
 	}
 	else if (!isHost && !clientConnected) // If not connected to a host, draw the connect screen objects.
 	{
-		window->draw(connectIP);
-		window->draw(connectPort);
-		window->draw(textBoxIP);
-		window->draw(textBoxIP.getText());
-		window->draw(textBoxPort);
-		window->draw(textBoxPort.getText());
+		snapshot.draw(connectIP);
+		snapshot.draw(connectPort);
+		snapshot.draw(textBoxIP);
+		snapshot.draw(textBoxIP.getText());
+		snapshot.draw(textBoxPort);
+		snapshot.draw(textBoxPort.getText());
 
 		if (connectionFailed) // Draw connection failed text when you fail to connect.
 		{
-			window->draw(connectionFailedText);
+			snapshot.draw(connectionFailedText);
+		}
+
+		if (networkManager->getMatchmaking()) // Draw matchmaking text while waiting for a match.
+		{
+			snapshot.draw(matchmakingText);
+		}
+
+		if (networkManager->getConnectState() == NetworkManager::CONNECTING) // Draw connection progress while connecting.
+		{
+			snapshot.draw(connectingText);
 		}
 	}
 }
@@ -586,29 +640,27 @@ void Lobby::reset()
 
 bool Lobby::connect()
 {
-	if (inputIP != "" && inputPort != "") // Check IP and port are not blank to prevent crash.
+	// Don't start another attempt while one is still in progress.
+	if (networkManager->getConnectState() == NetworkManager::CONNECTING)
 	{
-		// Attempt to connect to the other player using the user's entered IP and port.
-		if (networkManager->connect(sf::IpAddress(inputIP), std::stoi(inputPort)))
-		{
-			// If successful, set statuses and return true.
-			clientConnected = true;
-			connectionFailed = false;
-			return true;
-		}
-		else
-		{
-			// If unsuccessful, set statuses, reset text input and return false.
-			clientConnected = false;
-			connectionFailed = true;
-			inputIP = "";
-			inputPort = "";
-			textBoxSelection = 0;
-			return false;
-		}
 		return false;
 	}
-	
+
+	if (networkManager->getRelayConfigured() && inputPort != "") // When playing through a relay, only the match code is needed.
+	{
+		// Start joining the host's match on the relay. The network manager will be connected once the relay pairs both players.
+		networkManager->connectRelay(std::stoi(inputPort));
+		connectionFailed = false;
+		return true;
+	}
+	else if (inputIP != "" && inputPort != "") // Check IP and port are not blank to prevent crash.
+	{
+		// Start connecting to the other player using the user's entered IP and port. The result is checked in update, so the lobby keeps running while connecting.
+		networkManager->connect(sf::IpAddress(inputIP), std::stoi(inputPort));
+		connectionFailed = false;
+		return true;
+	}
+	return false;
 }
 
 void Lobby::setPostMatchLobby(int leftScore, int rightScore)
@@ -645,6 +697,7 @@ void Lobby::setupButtonsText()
 	backButton.setColour(notSelectedColour);
 	connectButton.setColour(notSelectedColour);
 	readyButton.setColour(notSelectedColour);
+	findMatchButton.setColour(notSelectedColour);
 
 	switch (currentSelection)
 	{
@@ -657,12 +710,18 @@ void Lobby::setupButtonsText()
 	case Selection::READY:
 		readyButton.setColour(selectedColour);
 		break;
+	case Selection::FIND_MATCH:
+		findMatchButton.setColour(selectedColour);
+		break;
 	}
 
 	connectionFailedText.setPosition(window->getSize().x * 0.4, window->getSize().y * 0.50);
+	matchmakingText.setPosition(window->getSize().x * 0.4, window->getSize().y * 0.70);
+	connectingText.setPosition(window->getSize().x * 0.4, window->getSize().y * 0.50);
 
 	backButton.setButtonPosition(window->getSize().x * 0.1, window->getSize().y * 0.8);
 	connectButton.setButtonPosition(window->getSize().x * 0.4 + connectButton.getSize().x * 0.5, window->getSize().y * 0.55);
+	findMatchButton.setButtonPosition(window->getSize().x * 0.4 + findMatchButton.getSize().x * 0.5, window->getSize().y * 0.62);
 	readyButton.setButtonPosition(window->getSize().x * 0.5, window->getSize().y * 0.8);
 
 	if (isHost)
@@ -687,6 +746,11 @@ void Lobby::setupButtonsText()
 	connectionStatus.setPosition(window->getSize().x * 0.5 - connectionStatus.getLocalBounds().width * 0.5, window->getSize().y * 0.10);
 	timer.setPosition(window->getSize().x * 0.5 - timer.getLocalBounds().width * 0.5, readyButton.getPosition().y - 30);
 
+	if (networkManager->getRelayConfigured())
+	{
+		connectPort.setString("Match Code: ");
+	}
+
 	connectIP.setPosition(window->getSize().x * 0.4, window->getSize().y * 0.4);
 	connectPort.setPosition(window->getSize().x * 0.4, window->getSize().y * 0.45);
 
@@ -708,22 +772,42 @@ void Lobby::setupButtonsText()
 	}
 
 
+	// Values are formatted into a buffer rather than a std::string, so nothing is allocated unless the text changes. Addresses are short enough to fit in a std::string without allocating.
+	char buffer[HudText::maxLength + 1];
+
 	if (isHost)
 	{
-		localIP.setString("Local IP: " + networkManager->getMyLocalIP());
-		hostIP.setString("Host IP: " + networkManager->getMyPublicIP());
-		hostPort.setString("Host Port: " + std::to_string(networkManager->getMyPort()));
+		std::snprintf(buffer, sizeof(buffer), "Local IP: %s", networkManager->getMyLocalIP().c_str());
+		localIP.setString(buffer);
+		std::snprintf(buffer, sizeof(buffer), "Host IP: %s", networkManager->getMyPublicIP().c_str());
+		hostIP.setString(buffer);
+
+		if (networkManager->getRelayConfigured()) // The client enters the relay match code instead of the host's port.
+		{
+			std::snprintf(buffer, sizeof(buffer), "Relay Match Code: %u", networkManager->getRelayMatchID());
+		}
+		else
+		{
+			std::snprintf(buffer, sizeof(buffer), "Host Port: %d", networkManager->getMyPort());
+		}
+		hostPort.setString(buffer);
 
-		clientIP.setString("Client IP: " + networkManager->getRecipientIP());
-		clientPort.setString("Client Port: " + std::to_string(networkManager->getRecipientPort()));
+		std::snprintf(buffer, sizeof(buffer), "Client IP: %s", networkManager->getRecipientIP().c_str());
+		clientIP.setString(buffer);
+		std::snprintf(buffer, sizeof(buffer), "Client Port: %d", networkManager->getRecipientPort());
+		clientPort.setString(buffer);
 	}
 	else
 	{
-		hostIP.setString("Host IP: " + networkManager->getRecipientIP());
-		hostPort.setString("Host Port: " + std::to_string(networkManager->getRecipientPort()));
+		std::snprintf(buffer, sizeof(buffer), "Host IP: %s", networkManager->getRecipientIP().c_str());
+		hostIP.setString(buffer);
+		std::snprintf(buffer, sizeof(buffer), "Host Port: %d", networkManager->getRecipientPort());
+		hostPort.setString(buffer);
 
-		clientIP.setString("Client IP: " + networkManager->getMyPublicIP());
-		clientPort.setString("Client Port: " + std::to_string(networkManager->getMyPort()));
+		std::snprintf(buffer, sizeof(buffer), "Client IP: %s", networkManager->getMyPublicIP().c_str());
+		clientIP.setString(buffer);
+		std::snprintf(buffer, sizeof(buffer), "Client Port: %d", networkManager->getMyPort());
+		clientPort.setString(buffer);
 	}
 
 	if (textBoxSelection == 0)
@@ -782,11 +866,16 @@ void Lobby::setupButtonsText()
 		hostReady.setString("Host Ready: NO");
 	}
 
-	std::stringstream stream;
-	stream << "Ready Countdown: " << std::fixed << std::setprecision(2) << startTimer;
-	std::string string = stream.str();
-	timer.setString(string);
+	std::snprintf(buffer, sizeof(buffer), "Ready Countdown: %.2f", startTimer);
+	timer.setString(buffer);
 
-	ping.setString("Ping: " + std::to_string(networkManager->getPing()));
+	std::snprintf(buffer, sizeof(buffer), "Ping: %d", networkManager->getPing());
+	ping.setString(buffer);
+
+	if (networkManager->getConnectState() == NetworkManager::CONNECTING)
+	{
+		std::snprintf(buffer, sizeof(buffer), "Connecting... %.1fs / %.1fs", networkManager->getConnectTime(), networkManager->getConnectTimeout());
+		connectingText.setString(buffer);
+	}
 	// ----
 }
\ No newline at end of file
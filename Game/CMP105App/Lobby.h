@@ -14,6 +14,10 @@
 #include "Cursor.h"
 #include "Button.h"
 #include "NetworkManager.h"
+#include "ResourceCache.h"
+#include "AssetLoader.h"
+#include "HudText.h"
+#include "RenderSnapshot.h"
 
 class MainMenu;
 class NetworkManager;
@@ -31,7 +35,7 @@ public:
 	// Main functions.
 	void handleInput(float dt);
 	void update(float dt);
-	void render();
+	void render(RenderSnapshot& snapshot);
 
 	// Initialise pointers and variables that rely on the pointers.
 	void init(GameState* gs, Input* in, sf::RenderWindow* hwnd, AudioManager* am, ObjectManager* om, MainMenu* mm, NetworkManager* nm);
@@ -90,7 +94,7 @@ public:
 	enum Character { MESSI = 0, RONALDO, KIRBY, MIEDEMA };
 private:
 	// Button selection.
-	enum Selection { BACK = 0, CONNECT, READY };
+	enum Selection { BACK = 0, CONNECT, READY, FIND_MATCH };
 	
 	// Pointers to objects needed in the class.
 	GameState* gameState;
@@ -101,8 +105,8 @@ private:
 	MainMenu* mainMenu;
 	NetworkManager* networkManager;
 
-	// Font to be used for all buttons and text.
-	sf::Font font;
+	// Font to be used for all buttons and text. Shared with the other menus through the resource cache.
+	std::shared_ptr<sf::Font> font;
 
 	// Button colours.
 	sf::Color selectedColour;
@@ -114,19 +118,21 @@ private:
 	// Cursor for interacting with buttons.
 	Cursor cursor;
 
-	// Text objects to display information about the network and game.
-	sf::Text localIP;
-	sf::Text hostIP; 
-	sf::Text hostPort; 
-	sf::Text hostReady;
-	sf::Text clientIP; 
-	sf::Text clientPort; 
-	sf::Text clientReady;
-	sf::Text ping; 
-	sf::Text connectionStatus; 
-	sf::Text timer;
+	// Text objects to display information about the network and game. Those set every update are HUD text, which is only rebuilt when what it shows changes.
+	HudText localIP;
+	HudText hostIP; 
+	HudText hostPort; 
+	HudText hostReady;
+	HudText clientIP; 
+	HudText clientPort; 
+	HudText clientReady;
+	HudText ping; 
+	HudText connectionStatus; 
+	HudText timer;
 	sf::Text connectionFailedText;
-	sf::Text previousScore;
+	sf::Text matchmakingText;
+	HudText connectingText;
+	HudText previousScore;
 	std::string score;
 
 	// Integer to store which text box is selected.
@@ -142,6 +148,9 @@ private:
 	Button textBoxPort;
 	Button connectButton;
 
+	// Only used if a matchmaker has been set. Asks the matchmaker to find a host instead of entering an IP and port.
+	Button findMatchButton;
+
 	// Buttons for leaving the lobby and readying up.
 	Button backButton;
 	Button readyButton;
@@ -167,10 +176,10 @@ private:
 	sf::Sprite rightPlayerPreview;
 
 	// Textures for each of the players.
-	sf::Texture messi;
-	sf::Texture ronaldo;
-	sf::Texture kirby;
-	sf::Texture miedema;
+	std::shared_ptr<sf::Texture> messi;
+	std::shared_ptr<sf::Texture> ronaldo;
+	std::shared_ptr<sf::Texture> kirby;
+	std::shared_ptr<sf::Texture> miedema;
 
 	// Buttons for switching between characters.
 	Button characterBack;
@@ -2,11 +2,8 @@
 
 MainMenu::MainMenu()
 {
-	// Load font
-	if (!font.loadFromFile("font/arial.ttf"))
-	{
-		std::cout << "Error loading font.\n";
-	}
+	// Get font from the shared cache.
+	font = ResourceCache::getShared().getFont("font/arial.ttf");
 
 	// Set colours
 	notSelectedColour = sf::Color::White;
@@ -19,9 +16,11 @@ MainMenu::MainMenu()
 	volume = 50;
 	maxVolume = 100;
 
+	quit = false;
+
 	// A text variable with default values, to be used to initialise button and text objects.
 	sf::Text buttonText;
-	buttonText.setFont(font);
+	buttonText.setFont(*font);
 	buttonText.setCharacterSize(80);
 	buttonText.setFillColor(notSelectedColour);
 	buttonText.setOutlineColor(sf::Color::Black);
@@ -48,7 +47,7 @@ MainMenu::MainMenu()
 	buttonText.setString("MUTE");
 	mute.setText(buttonText);
 
-	volumeText = buttonText;
+	volumeText.setStyle(buttonText);
 
 	buttonText.setCharacterSize(30);
 	controls = buttonText;
@@ -117,7 +116,7 @@ void MainMenu::handleInput(float dt)
 			input->setMouseLDown(false);
 
 			// Exit game.
-			window->close();
+			quit = true;
 		}
 	}
 	else if (Collision::checkBoundingBox(&cursor, &increaseVolume)) // Increase volume when the user clicks this button.
@@ -158,9 +157,6 @@ void MainMenu::handleInput(float dt)
 
 void MainMenu::update(float dt)
 {
-	sf::View view(sf::FloatRect(0, 0, window->getSize().x, window->getSize().y));
-	window->setView(view);
-
 	// Update cursor position.
 	cursor.update(dt);
 
@@ -182,7 +178,10 @@ void MainMenu::update(float dt)
 	audio->setSoundVolume(volume);
 
 	// Setup volume buttons and text.
-	volumeText.setString("Volume: " + std::to_string(volume));
+	// Only rebuilt when the volume changes.
+	char buffer[HudText::maxLength + 1];
+	std::snprintf(buffer, sizeof(buffer), "Volume: %d", volume);
+	volumeText.setString(buffer);
 	volumeText.setPosition(window->getSize().x / 2 - volumeText.getLocalBounds().width / 2, window->getSize().y * 0.9);
 	decreaseVolume.setButtonSize(50, 50);
 	decreaseVolume.setButtonPosition(volumeText.getPosition().x - decreaseVolume.getSize().x - 20, volumeText.getPosition().y, Button::Alignment::LEFT);
@@ -205,30 +204,30 @@ void MainMenu::update(float dt)
 	}
 }
 
-void MainMenu::render()
+void MainMenu::render(RenderSnapshot& snapshot)
 {
 	// Render buttons and text objects.
-	//window->draw(hostButton);
-	window->draw(hostButton.getText());
+	//snapshot.draw(hostButton);
+	snapshot.draw(hostButton.getText());
 
-	//window->draw(joinButton);
-	window->draw(joinButton.getText());
+	//snapshot.draw(joinButton);
+	snapshot.draw(joinButton.getText());
 	
-	//window->draw(quitButton);
-	window->draw(quitButton.getText());
+	//snapshot.draw(quitButton);
+	snapshot.draw(quitButton.getText());
 
-	window->draw(increaseVolume);
-	window->draw(increaseVolume.getText());
+	snapshot.draw(increaseVolume);
+	snapshot.draw(increaseVolume.getText());
 
-	window->draw(decreaseVolume);
-	window->draw(decreaseVolume.getText());
+	snapshot.draw(decreaseVolume);
+	snapshot.draw(decreaseVolume.getText());
 
-	window->draw(mute);
-	window->draw(mute.getText());
+	snapshot.draw(mute);
+	snapshot.draw(mute.getText());
 
-	window->draw(volumeText);
+	snapshot.draw(volumeText);
 
-	window->draw(controls);
+	snapshot.draw(controls);
 }
 
 
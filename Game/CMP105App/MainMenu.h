@@ -10,6 +10,9 @@
 #include "ObjectManager.h"
 #include "Lobby.h"
 #include "Cursor.h"
+#include "ResourceCache.h"
+#include "HudText.h"
+#include "RenderSnapshot.h"
 #include "Button.h"
 #include "NetworkManager.h"
 
@@ -28,11 +31,17 @@ public:
 	// Main functions.
 	void handleInput(float dt);
 	void update(float dt);
-	void render();
+	void render(RenderSnapshot& snapshot);
 
 	// Initialise pointers and variables that rely on them.
 	void init(GameState* gs, Input* in, sf::RenderWindow* hwnd, ObjectManager* om, Lobby* l, NetworkManager* nm, AudioManager* a);
 
+	// Whether the user has chosen to quit. The window is closed by the level, which has to stop the render thread first.
+	bool getQuit()
+	{
+		return quit;
+	};
+
 private:
 	// Enum for button selection.
 	enum Selection { HOST = 0, JOIN, QUIT };
@@ -46,8 +55,8 @@ private:
 	Lobby* lobby;
 	NetworkManager* networkManager;
 	
-	// Font to be used for all text and button objects.
-	sf::Font font;
+	// Font to be used for all text and button objects. Shared with the other menus through the resource cache.
+	std::shared_ptr<sf::Font> font;
 
 	// Text object that displays the game's controls.
 	sf::Text controls;
@@ -62,7 +71,10 @@ private:
 	// Volume variables.
 	int volume;
 	int maxVolume;
-	sf::Text volumeText;
+	HudText volumeText;
+
+	// Set when the quit button is clicked.
+	bool quit;
 
 	// Buttons.
 	Button hostButton;
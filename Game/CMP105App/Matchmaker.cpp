@@ -0,0 +1,299 @@
+#include "Matchmaker.h"
+
+Matchmaker::Matchmaker()
+{
+	// Send 3 probes to each player and use the fastest.
+	probeCount = 3;
+
+	// Most players connected at once. Further connections are turned away. The operating system's limit on open sockets may be lower.
+	maxTickets = 10000;
+}
+
+Matchmaker::~Matchmaker()
+{
+}
+
+void Matchmaker::run(unsigned short port)
+{
+	// Setup TCP listener. It doesn't block so that all pending connections can be accepted each time the poller wakes up.
+	if (tcpListener.listen(port) != sf::Socket::Done)
+	{
+		std::cout << "Matchmaker could not listen on port " << port << ".\n";
+		return;
+	}
+
+	tcpListener.setBlocking(false);
+	poller.add(tcpListener);
+
+	std::cout << "Matchmaker running on port " << port << ".\n";
+
+	while (true)
+	{
+		// Wait until at least one socket has data or can send what it has queued.
+		if (poller.wait(sf::seconds(1)))
+		{
+			if (poller.isReady(tcpListener))
+			{
+				acceptConnections();
+			}
+
+			receiveTCP();
+		}
+
+		// Send what can be sent of each ticket's queue, and only watch for being able to send while something is queued. Finished tickets close once their queue is empty.
+		for (std::list<Ticket>::iterator it = tickets.begin(); it != tickets.end(); ++it)
+		{
+			if (it->socket.hasQueued() && poller.isWritable(it->socket.getSocket()))
+			{
+				it->socket.flush();
+			}
+			else if (it->done)
+			{
+				it->socket.closeWhenSent();
+			}
+			poller.setWatchWritable(it->socket.getSocket(), it->socket.hasQueued());
+		}
+
+		removeDoneTickets();
+	}
+}
+
+void Matchmaker::acceptConnections()
+{
+	// Accept connections until there are none left waiting.
+	while (true)
+	{
+		tickets.emplace_back();
+		Ticket& ticket = tickets.back();
+		if (tcpListener.accept(ticket.socket.getSocket()) != sf::Socket::Done)
+		{
+			tickets.pop_back();
+			return;
+		}
+
+		// Turn the player away once full, closing the connection straight away so they know.
+		if (tickets.size() > maxTickets)
+		{
+			tickets.pop_back();
+			std::cout << "Matchmaker: full, turned a player away.\n";
+			continue;
+		}
+
+		ticket.socket.getSocket().setBlocking(false);
+		poller.add(ticket.socket.getSocket());
+
+		ticket.host = false;
+		ticket.registered = false;
+		ticket.port = 0;
+		ticket.probesLeft = 0;
+		ticket.probeSendTime = 0;
+		ticket.rtt = 0;
+		ticket.queued = false;
+		ticket.done = false;
+	}
+}
+
+void Matchmaker::receiveTCP()
+{
+	// Receive every whole packet from each ticket that has data waiting.
+	for (std::list<Ticket>::iterator it = tickets.begin(); it != tickets.end(); ++it)
+	{
+		if (it->done || !poller.isReady(it->socket.getSocket()))
+		{
+			continue;
+		}
+
+		sf::Packet packet;
+		sf::Socket::Status status = sf::Socket::NotReady;
+		while (!it->done && (status = it->socket.receive(packet)) == sf::Socket::Done)
+		{
+			handlePacket(*it, packet);
+			packet.clear();
+		}
+
+		if (status == sf::Socket::Disconnected || status == sf::Socket::Error)
+		{
+			// Player has given up waiting. Take them out of the queue, and close straight away as there is no one to send to.
+			dequeue(*it);
+			it->done = true;
+			it->socket.close();
+		}
+	}
+}
+
+void Matchmaker::handlePacket(Ticket& ticket, sf::Packet packet)
+{
+	unsigned short type;
+	packet >> type;
+
+	switch (type)
+	{
+	case NetworkManager::MATCHMAKER_REGISTER:
+		// Host registering. Save the port it is listening on and its local IP, then start measuring round trip time.
+		if (!ticket.registered && packet >> ticket.port >> ticket.localIP)
+		{
+			ticket.host = true;
+			ticket.registered = true;
+			ticket.probesLeft = probeCount;
+			sendProbe(ticket);
+		}
+		break;
+	case NetworkManager::MATCHMAKER_REQUEST:
+		// Client asking for a match. Measure round trip time first.
+		if (!ticket.registered)
+		{
+			ticket.host = false;
+			ticket.registered = true;
+			ticket.probesLeft = probeCount;
+			sendProbe(ticket);
+		}
+		break;
+	case NetworkManager::MATCHMAKER_PROBE:
+		// Probe has come back. Keep the fastest round trip time, then send the next probe or queue the player.
+		if (ticket.registered && ticket.probesLeft > 0)
+		{
+			int rtt = int(getTime() - ticket.probeSendTime);
+			if (ticket.probesLeft == probeCount || rtt < ticket.rtt)
+			{
+				ticket.rtt = rtt;
+			}
+
+			ticket.probesLeft--;
+			if (ticket.probesLeft > 0)
+			{
+				sendProbe(ticket);
+			}
+			else
+			{
+				enqueue(ticket);
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void Matchmaker::sendProbe(Ticket& ticket)
+{
+	// Setup packet with type. The player sends the same packet straight back.
+	sf::Packet packet;
+	unsigned short type = NetworkManager::MATCHMAKER_PROBE;
+	packet << type;
+
+	ticket.probeSendTime = getTime();
+	if (!ticket.socket.send(packet))
+	{
+		dequeue(ticket);
+		ticket.done = true;
+	}
+}
+
+void Matchmaker::enqueue(Ticket& ticket)
+{
+	// Look for the best waiting player on the other side. If there is one, match them straight away.
+	std::multimap<int, Ticket*>& otherQueue = ticket.host ? clients : hosts;
+	std::multimap<int, Ticket*>::iterator closest = findClosest(otherQueue, ticket.rtt);
+
+	if (closest != otherQueue.end())
+	{
+		Ticket* other = closest->second;
+		dequeue(*other);
+
+		if (ticket.host)
+		{
+			match(ticket, *other);
+		}
+		else
+		{
+			match(*other, ticket);
+		}
+		return;
+	}
+
+	// Otherwise wait in the queue.
+	std::multimap<int, Ticket*>& queue = ticket.host ? hosts : clients;
+	ticket.queuePosition = queue.insert(std::make_pair(ticket.rtt, &ticket));
+	ticket.queued = true;
+
+	std::cout << "Matchmaker: " << (ticket.host ? "host" : "client") << " waiting with " << ticket.rtt << "ms round trip time. "
+		<< hosts.size() << " hosts and " << clients.size() << " clients waiting.\n";
+}
+
+void Matchmaker::dequeue(Ticket& ticket)
+{
+	if (ticket.queued)
+	{
+		if (ticket.host)
+		{
+			hosts.erase(ticket.queuePosition);
+		}
+		else
+		{
+			clients.erase(ticket.queuePosition);
+		}
+		ticket.queued = false;
+	}
+}
+
+std::multimap<int, Matchmaker::Ticket*>::iterator Matchmaker::findClosest(std::multimap<int, Ticket*>& queue, int rtt)
+{
+	// First waiting player with a round trip time at least as long as ours.
+	std::multimap<int, Ticket*>::iterator above = queue.lower_bound(rtt);
+
+	if (above == queue.begin())
+	{
+		return above;
+	}
+
+	// Compare with the player just below, and return whichever is closer.
+	std::multimap<int, Ticket*>::iterator below = std::prev(above);
+	if (above == queue.end() || rtt - below->first <= above->first - rtt)
+	{
+		return below;
+	}
+	return above;
+}
+
+void Matchmaker::match(Ticket& host, Ticket& client)
+{
+	// Send the host's public IP (as seen by the matchmaker), port and local IP to the client.
+	sf::Packet packet;
+	unsigned short type = NetworkManager::MATCHMAKER_MATCH;
+	std::string publicIP = host.socket.getRemoteAddress().toString();
+	packet << type << publicIP << host.port << host.localIP;
+	client.socket.send(packet);
+
+	// Let the host know it has been matched, so it stops waiting in the queue.
+	sf::Packet hostPacket;
+	hostPacket << type;
+	host.socket.send(hostPacket);
+
+	std::cout << "Matchmaker: matched host " << publicIP << ":" << host.port << " (" << host.rtt << "ms) with client "
+		<< client.socket.getRemoteAddress().toString() << " (" << client.rtt << "ms).\n";
+
+	// Both tickets are finished with. Their sockets close once the match details have been sent.
+	host.done = true;
+	client.done = true;
+	host.socket.closeWhenSent();
+	client.socket.closeWhenSent();
+}
+
+void Matchmaker::removeDoneTickets()
+{
+	std::list<Ticket>::iterator it = tickets.begin();
+	while (it != tickets.end())
+	{
+		// Tickets are removed from the list, which disconnects them, once their socket has closed. A ticket whose socket closed because it stopped reading is taken out of the queue first.
+		if (it->socket.isClosed())
+		{
+			dequeue(*it);
+			poller.remove(it->socket.getSocket());
+			it = tickets.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
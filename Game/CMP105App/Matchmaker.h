@@ -0,0 +1,85 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <iostream>
+#include <chrono>
+#include <list>
+#include <map>
+#include <memory>
+#include "NetworkManager.h"
+#include "SocketPoller.h"
+#include "BufferedSocket.h"
+
+// Matchmaker class. Runs as its own process (started with "-matchmaker-server <port>"), and can be run locally as a stand-in for a real server.
+// Hosts register themselves and clients ask for a match. The matchmaker measures its round trip time to every player, and pairs each client with the waiting host whose round trip time is closest to its own.
+// Waiting players are kept in queues sorted by round trip time, so finding the best match is O(log n). The client is handed the host's public and local IP and port, which can be passed straight to NetworkManager::connect.
+// Sockets don't block and are watched with a socket poller, the same as the relay, so thousands of players can wait at once. Past maxTickets, new connections are turned away.
+class Matchmaker
+{
+public:
+	Matchmaker();
+	~Matchmaker();
+
+	// Start the matchmaker on the given port. Runs until the process is closed.
+	void run(unsigned short port);
+
+private:
+	// A player connected to the matchmaker.
+	struct Ticket
+	{
+		BufferedSocket socket;
+		bool host;
+		bool registered;
+
+		// Details handed to the client when a host is matched.
+		unsigned short port;
+		std::string localIP;
+
+		// Round trip time measurement. The lowest of several probes is used, as it is the least affected by queuing.
+		int probesLeft;
+		long long probeSendTime;
+		int rtt;
+
+		// Position in the host or client queue, so the ticket can be removed without searching.
+		bool queued;
+		std::multimap<int, Ticket*>::iterator queuePosition;
+
+		// Set once the ticket has been matched or has disconnected. It is removed once its socket has closed, after anything still queued has been sent.
+		bool done;
+	};
+
+	// Functions for handling new connections, packets and disconnects.
+	void acceptConnections();
+	void receiveTCP();
+	void handlePacket(Ticket& ticket, sf::Packet packet);
+	void sendProbe(Ticket& ticket);
+	void enqueue(Ticket& ticket);
+	void dequeue(Ticket& ticket);
+	void removeDoneTickets();
+
+	// Find the ticket in the queue whose round trip time is closest to the given time. Returns the end of the queue if it is empty.
+	std::multimap<int, Ticket*>::iterator findClosest(std::multimap<int, Ticket*>& queue, int rtt);
+
+	// Send the host's connection details to the client, and tell the host it has been matched.
+	void match(Ticket& host, Ticket& client);
+
+	// Function to get the current time in milliseconds.
+	long long getTime()
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	};
+
+	// Listener and poller used to wait for incoming data on all sockets at once.
+	sf::TcpListener tcpListener;
+	SocketPoller poller;
+
+	// Most players connected at once.
+	std::size_t maxTickets;
+
+	// All connected players, and the queues of waiting hosts and clients sorted by round trip time.
+	std::list<Ticket> tickets;
+	std::multimap<int, Ticket*> hosts;
+	std::multimap<int, Ticket*> clients;
+
+	// How many round trip time probes to send to each player.
+	int probeCount;
+};
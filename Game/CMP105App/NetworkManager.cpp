@@ -11,19 +11,21 @@ NetworkManager::NetworkManager()
 	pingRate = 1;
 	pingValue = 0;
 
-	// Set TCP socket to non blocking.
-	tcpSocket.setBlocking(false);
+	// Create TCP socket and set it to non blocking.
+	tcpSocket.reset(new sf::TcpSocket);
+	tcpSocket->setBlocking(false);
 	tcpListener.setBlocking(false);
 
 	// Setup TCP listener.
-	if (tcpListener.listen(tcpSocket.getLocalPort() != sf::Socket::Done))
+	if (tcpListener.listen(tcpSocket->getLocalPort() != sf::Socket::Done))
 	{
 		// error
 	};
 
-	// Set IP and port variables.
+	// Set IP and port variables. Looking up the public IP blocks on an HTTP request (for a long time when offline), so it runs on another thread instead of delaying startup.
 	myLocalIP = sf::IpAddress::getLocalAddress();
-	myPublicIP = sf::IpAddress::getPublicAddress();
+	publicIPLookup = std::async(std::launch::async, []() { return sf::IpAddress::getPublicAddress(sf::seconds(5)); });
+	publicIPReady = false;
 	myPort = tcpListener.getLocalPort();
 	
 	// Setup UDP socket on same port number as the TCP listener.
@@ -35,12 +37,48 @@ NetworkManager::NetworkManager()
 	connected = false;
 	isUdpSetup = false;
 	toSendCollision = false;
-
-	mostRecentVelocity = sf::Vector2f(0, 0);
-	mostRecentPosition = sf::Vector2f(0, 0);
-	mostRecentPositionTime = 0;
-	mostRecentBallCollisionTime = 0;
+	collisionKickState = 0;
+
+	relayConfigured = false;
+	viaRelay = false;
+	awaitingRelayPair = false;
+	relayRegistered = false;
+	relayPort = 0;
+	relayMatchID = 0;
+
+	matchmakerConfigured = false;
+	matchmaking = false;
+	matchmakerPort = 0;
+	matchmakerRetryTime = 0;
+	matchmakerRequestPending = false;
+	matchmakerConnectTime = 0;
+
+	connectState = NOT_CONNECTING;
+	connectTimeout = 5;
+	connectStartTime = 0;
+	connectingToRelay = false;
+
+	sessionToken = 0;
+	reconnecting = false;
+	reconnectSocketLost = false;
+	reconnectStartTime = 0;
+	reconnectRetryTime = 0;
+	resumeAcceptTime = 0;
+
+	// Keep playing for up to 10 seconds while trying to resume, and extrapolate the other player for half a second after their last update.
+	gracePeriod = 10;
+	maxExtrapolationTime = 0.5;
+	lastPositionReceiveTime = 0;
+
+	// 1v1 unless set from the command line.
+	teamSize = 1;
+	matchSeed = 0;
+	streams.resize(ObjectManager::maxTeamSize * 2);
+	resetPositionData();
 	// ----
+
+	// Seed the random number generator used for session tokens and relay match IDs with time.
+	srand(std::time(NULL));
 }
 
 NetworkManager::~NetworkManager()
@@ -48,6 +86,31 @@ NetworkManager::~NetworkManager()
 
 }
 
+// Returns the public IP once the background lookup has finished.
+std::string NetworkManager::getMyPublicIP()
+{
+	if (!publicIPReady)
+	{
+		// Check without waiting whether the lookup has finished.
+		if (publicIPLookup.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return "Finding...";
+		}
+
+		// Save the result so the lookup is only done once.
+		myPublicIP = publicIPLookup.get();
+		publicIPReady = true;
+	}
+
+	// The lookup fails if there is no internet connection.
+	if (myPublicIP == sf::IpAddress::None)
+	{
+		return "Unavailable";
+	}
+
+	return myPublicIP.toString();
+}
+
 void NetworkManager::init(GameState* gs, Lobby* l, ObjectManager* om, AudioManager* a)
 {
 	// Setup pointers.
@@ -68,12 +131,14 @@ void NetworkManager::ping()
 
 	// Attempt to send a packet...
 	sf::Socket::Status status;
-	if ((status = tcpSocket.send(packet)) != sf::Socket::Done)
+	if ((status = tcpSocket->send(packet)) != sf::Socket::Done)
 	{
-		// Call disconnect function if the socket has disconnect.
+		// The socket has disconnected. If connected through a relay, the relay connection itself has been lost.
+		// During a match this starts the grace period instead of disconnecting straight away.
 		if (status == sf::Socket::Disconnected)
 		{
-			disconnect();
+			viaRelay = false;
+			connectionLost(true);
 		}
 	}
 	else
@@ -93,7 +158,7 @@ void NetworkManager::pong()
 	packet << type;
 
 	// Attempt to send a packet...
-	if (tcpSocket.send(packet) != sf::Socket::Done)
+	if (tcpSocket->send(packet) != sf::Socket::Done)
 	{
 		// Error
 	}
@@ -107,36 +172,287 @@ void NetworkManager::pong()
 // Reset function - disconnect the TCP socket and set values back to default.
 void NetworkManager::reset()
 {
-	tcpSocket.disconnect();
+	tcpSocket->disconnect();
+	viaRelay = false;
 
-	mostRecentVelocity = sf::Vector2f(0, 0);
-	mostRecentPosition = sf::Vector2f(0, 0);
-	mostRecentPositionTime = 0;
-	mostRecentBallCollisionTime = 0;
+	matchmakerSocket.disconnect();
+	matchmaking = false;
+	matchmakerRetryTime = 0;
+	matchmakerRequestPending = false;
+
+	connectAttempts.clear();
+	connectState = NOT_CONNECTING;
+	connectingToRelay = false;
+
+	resetPositionData();
 }
 
-// Connect function used by the client trying to connect to the host.
-bool NetworkManager::connect(sf::IpAddress IP, int port)
+// Connect function used by the client trying to connect to the host. Connecting doesn't block, so the game keeps running while updateConnect() checks for the result each frame.
+void NetworkManager::connect(sf::IpAddress IP, int port)
 {
-	// Set the TCP socket to block while connecting.
-	tcpSocket.setBlocking(true);
-	sf::Socket::Status status = tcpSocket.connect(IP, port);
+	std::vector<sf::IpAddress> addresses;
+	addresses.push_back(IP);
+	connect(addresses, port);
+}
 
-	// If the connect attempt failed, stop blocking and return false.
-	if (status != sf::Socket::Done)
+// Connect to whichever address answers first, such as the host's public and local IPs. All of the addresses are tried at the same time.
+void NetworkManager::connect(const std::vector<sf::IpAddress>& addresses, int port)
+{
+	// Stop any previous attempts.
+	connectAttempts.clear();
+	connectingToRelay = false;
+
+	for (int i = 0; i < addresses.size(); i++)
 	{
-		tcpSocket.setBlocking(false);
-		return false;
+		if (addresses[i] == sf::IpAddress::None)
+		{
+			continue;
+		}
+
+		// A non blocking socket returns straight away and carries on connecting in the background.
+		std::unique_ptr<sf::TcpSocket> attempt(new sf::TcpSocket);
+		attempt->setBlocking(false);
+		sf::Socket::Status status = attempt->connect(addresses[i], port);
+
+		if (status == sf::Socket::Done || status == sf::Socket::NotReady)
+		{
+			connectAttempts.push_back(std::move(attempt));
+		}
+	}
+
+	connectStartTime = getSystemTime();
+
+	if (connectAttempts.empty())
+	{
+		connectState = CONNECT_FAILED;
+	}
+	else
+	{
+		connectState = CONNECTING;
+	}
+}
+
+// Check whether any of the connection attempts have finished. Called every frame while connecting.
+void NetworkManager::updateConnect()
+{
+	// A socket has connected once it knows the address of the other end. Use the first one to connect and close the rest.
+	for (int i = 0; i < connectAttempts.size(); i++)
+	{
+		if (connectAttempts[i]->getRemoteAddress() != sf::IpAddress::None)
+		{
+			tcpSocket = std::move(connectAttempts[i]);
+			connectAttempts.clear();
+			connectState = NOT_CONNECTING;
+			onConnected();
+			return;
+		}
+	}
+
+	// Give up once the timeout has passed.
+	if (getConnectTime() > connectTimeout)
+	{
+		std::cout << "Connection timed out.\n";
+		connectAttempts.clear();
+		connectState = CONNECT_FAILED;
+	}
+}
+
+// Called once the TCP socket has connected, either to the host or to the relay.
+void NetworkManager::onConnected()
+{
+	if (connectingToRelay)
+	{
+		// Send join packet with the match and which side we are.
+		sf::Packet packet;
+		unsigned short type = RELAY_JOIN;
+		unsigned short role = isHost ? 0 : 1;
+		packet << type << relayMatchID << role;
+
+		if (tcpSocket->send(packet) != sf::Socket::Done)
+		{
+			tcpSocket->disconnect();
+			connectState = CONNECT_FAILED;
+			return;
+		}
+
+		std::cout << "Joined relay match " << relayMatchID << ".\n";
+
+		// All traffic now goes to and comes from the relay. Not connected until the relay pairs us with the other player, so a lost session isn't resumed until then either.
+		connectingToRelay = false;
+		viaRelay = true;
+		awaitingRelayPair = true;
+		relayRegistered = false;
+		sendRelayJoinUDP();
+	}
+	else if (reconnecting) // Reconnected to the host during a match. Send the session token so the host can send back a snapshot to resume from.
+	{
+		std::cout << "Reconnected, resuming session.\n";
+		reconnectSocketLost = false;
+		sendResume();
 	}
-	else // Otherwise connection was successful. Set blocking to false, connected to true, setup recipient information and send the currently selected character to the host.
+	else // Connected to the host. Set connected to true, setup recipient information and send the currently selected character to the host.
 	{
 		std::cout << "Successfully connected.\n";
-		tcpSocket.setBlocking(false);
 		connected = true;
-		recipientIP = tcpSocket.getRemoteAddress();
-		recipientPort = tcpSocket.getRemotePort();
+		recipientIP = tcpSocket->getRemoteAddress();
+		recipientPort = tcpSocket->getRemotePort();
 		sendCharacter(lobby->getClientChar());
-		return true;
+	}
+}
+
+// Connect function used by both the host and the client when playing through a relay server. Doesn't block, in the same way as connect().
+void NetworkManager::connectRelay(unsigned int matchID)
+{
+	connect(relayIP, relayPort);
+	connectingToRelay = true;
+	relayMatchID = matchID;
+}
+
+// Register our UDP endpoint with the relay. Sent every tick until the relay confirms it with RELAY_REGISTERED, as UDP packets can be lost and the relay only accepts it once our TCP join has arrived.
+void NetworkManager::sendRelayJoinUDP()
+{
+	sf::Packet packet;
+	unsigned short type = RELAY_JOIN;
+	unsigned short role = isHost ? 0 : 1;
+	packet << type << relayMatchID << role;
+
+	if (udpSocket.send(packet, relayIP, relayPort))
+	{
+		// Error
+	}
+}
+
+// Start connecting to the matchmaker. The request is sent from receiveMatchmaker() once connected, so that the game doesn't block.
+bool NetworkManager::sendToMatchmaker(sf::Packet& packet)
+{
+	matchmakerSocket.disconnect();
+	matchmakerSocket.setBlocking(false);
+
+	sf::Socket::Status status = matchmakerSocket.connect(matchmakerIP, matchmakerPort);
+	if (status != sf::Socket::Done && status != sf::Socket::NotReady)
+	{
+		return false;
+	}
+
+	matchmakerRequest = packet;
+	matchmakerRequestPending = true;
+	matchmakerConnectTime = getSystemTime();
+	matchmaking = true;
+	return true;
+}
+
+// Ask the matchmaker for a match. Used by the client.
+bool NetworkManager::findMatch()
+{
+	sf::Packet packet;
+	unsigned short type = MATCHMAKER_REQUEST;
+	packet << type;
+
+	if (!sendToMatchmaker(packet))
+	{
+		std::cout << "Could not reach matchmaker.\n";
+		return false;
+	}
+
+	std::cout << "Searching for a match.\n";
+	return true;
+}
+
+// Register with the matchmaker so that clients can find this game. Used by the host.
+bool NetworkManager::registerHost()
+{
+	// Setup packet with type, the port being listened on, and local IP so that clients on the same network can connect too.
+	sf::Packet packet;
+	unsigned short type = MATCHMAKER_REGISTER;
+	std::string localIP = myLocalIP.toString();
+	packet << type << myPort << localIP;
+
+	if (!sendToMatchmaker(packet))
+	{
+		// Try again in 5 seconds.
+		matchmakerRetryTime = getSystemTime() + 5000;
+		return false;
+	}
+
+	std::cout << "Registering with matchmaker.\n";
+	return true;
+}
+
+// Handle packets from the matchmaker.
+void NetworkManager::receiveMatchmaker()
+{
+	sf::Packet packet;
+	unsigned short type;
+	sf::Socket::Status status;
+
+	// Send the request once connected. Give up if the matchmaker can't be reached in time.
+	if (matchmakerRequestPending)
+	{
+		if (matchmakerSocket.getRemoteAddress() == sf::IpAddress::None)
+		{
+			if (getSystemTime() - matchmakerConnectTime > connectTimeout * 1000)
+			{
+				std::cout << "Could not reach matchmaker.\n";
+				matchmakerSocket.disconnect();
+				matchmakerRequestPending = false;
+				matchmaking = false;
+				matchmakerRetryTime = getSystemTime() + 5000;
+			}
+			return;
+		}
+
+		matchmakerSocket.send(matchmakerRequest);
+		matchmakerRequestPending = false;
+	}
+
+	while ((status = matchmakerSocket.receive(packet)) == sf::Socket::Done)
+	{
+		packet >> type;
+
+		if (type == MATCHMAKER_PROBE)
+		{
+			// Send the probe straight back so that the matchmaker can measure round trip time.
+			matchmakerSocket.send(packet);
+		}
+		else if (type == MATCHMAKER_MATCH)
+		{
+			// Matched, so the matchmaker is no longer needed.
+			matchmaking = false;
+			matchmakerSocket.disconnect();
+
+			if (isHost)
+			{
+				// Keep listening for the client. If it hasn't connected in 10 seconds, register again.
+				std::cout << "Matched, waiting for client.\n";
+				matchmakerRetryTime = getSystemTime() + 10000;
+			}
+			else
+			{
+				// Connect to the host using the details handed back. The public and local IPs are tried at the same time, as the public IP may not be reachable if both players are on the same network.
+				std::string publicIP;
+				unsigned short port;
+				std::string localIP;
+				packet >> publicIP >> port >> localIP;
+
+				std::cout << "Match found.\n";
+				std::vector<sf::IpAddress> addresses;
+				addresses.push_back(sf::IpAddress(publicIP));
+				if (localIP != publicIP)
+				{
+					addresses.push_back(sf::IpAddress(localIP));
+				}
+				connect(addresses, port);
+			}
+			return;
+		}
+	}
+
+	// Lost connection to the matchmaker. The host will register again after a few seconds.
+	if (status == sf::Socket::Disconnected)
+	{
+		std::cout << "Lost connection to matchmaker.\n";
+		matchmaking = false;
+		matchmakerRetryTime = getSystemTime() + 5000;
 	}
 }
 
@@ -157,12 +473,283 @@ void NetworkManager::disconnect()
 	hostReady = false;
 	clientReady = false;
 	pingValue = 0;
+
+	sessionToken = 0;
+	reconnecting = false;
+	reconnectSocketLost = false;
+	awaitingRelayPair = false;
+	relayRegistered = false;
+	resumeSocket.reset();
+
 	gameState->setCurrentState(State::LOBBY);
 }
 
+// Called when the connection to the other player has been lost. During a match the game keeps running for the grace period while the session is resumed, otherwise disconnect straight away.
+// socketLost is true if our own socket has been lost and needs reconnecting, or false if we are still connected and are waiting for the other player to come back.
+void NetworkManager::connectionLost(bool socketLost)
+{
+	if (gameState->getCurrentState() != State::LEVEL || sessionToken == 0)
+	{
+		disconnect();
+		return;
+	}
+
+	if (!reconnecting)
+	{
+		std::cout << "Connection lost, trying to resume.\n";
+		reconnecting = true;
+		reconnectStartTime = getSystemTime();
+		reconnectRetryTime = 0;
+	}
+
+	if (socketLost)
+	{
+		reconnectSocketLost = true;
+		awaitingRelayPair = false;
+		relayRegistered = false;
+	}
+}
+
+// Called every tick while reconnecting. Gives up once the grace period is over, otherwise keeps trying to reconnect.
+void NetworkManager::updateReconnect()
+{
+	// The session can only be resumed during a match.
+	if (gameState->getCurrentState() != State::LEVEL || getSystemTime() - reconnectStartTime > gracePeriod * 1000)
+	{
+		std::cout << "Could not resume session.\n";
+		connectAttempts.clear();
+		connectState = NOT_CONNECTING;
+		disconnect();
+		return;
+	}
+
+	// Try to reconnect once a second. Through a relay both players join the same match again, otherwise the client connects to the host and the host waits in acceptResume().
+	// Once joined to the relay, wait there to be paired with the other player rather than joining again.
+	if (reconnectSocketLost && !awaitingRelayPair && connectState != CONNECTING && getSystemTime() > reconnectRetryTime)
+	{
+		reconnectRetryTime = getSystemTime() + 1000;
+
+		if (relayConfigured)
+		{
+			connectRelay(relayMatchID);
+		}
+		else if (!isHost)
+		{
+			connect(recipientIP, recipientPort);
+		}
+	}
+}
+
+// Accept a reconnecting client on a separate socket. The socket only replaces the current connection once the client has sent the right session token.
+void NetworkManager::acceptResume()
+{
+	if (!resumeSocket)
+	{
+		resumeSocket.reset(new sf::TcpSocket);
+		resumeSocket->setBlocking(false);
+	}
+
+	// Check if anyone is trying to connect.
+	if (resumeSocket->getRemoteAddress() == sf::IpAddress::None)
+	{
+		if (tcpListener.accept(*resumeSocket) == sf::Socket::Done)
+		{
+			resumeAcceptTime = getSystemTime();
+		}
+		return;
+	}
+
+	// Wait for the session token.
+	sf::Packet packet;
+	unsigned short type;
+	sf::Socket::Status status = resumeSocket->receive(packet);
+
+	if (status == sf::Socket::Done && packet >> type && type == RESUME)
+	{
+		// Swap the sockets before replying, so that the snapshot is sent on the new connection.
+		std::unique_ptr<sf::TcpSocket> oldSocket = std::move(tcpSocket);
+		tcpSocket = std::move(resumeSocket);
+
+		if (handleResume(packet))
+		{
+			// The client may have come back from a different address. UDP is setup again from the next position received.
+			recipientIP = tcpSocket->getRemoteAddress();
+			isUdpSetup = false;
+			return;
+		}
+
+		// Wrong token. Go back to the old connection.
+		resumeSocket = std::move(tcpSocket);
+		tcpSocket = std::move(oldSocket);
+		resumeSocket->disconnect();
+	}
+	else if (status == sf::Socket::Done || status == sf::Socket::Disconnected || status == sf::Socket::Error || getSystemTime() - resumeAcceptTime > connectTimeout * 1000)
+	{
+		// Drop anything that isn't a reconnecting client.
+		resumeSocket->disconnect();
+	}
+}
+
+// Send the session token, team size and match seed to the client. Sent by the host when the client connects.
+void NetworkManager::sendSession()
+{
+	// Generate a new token. 0 means there is no session.
+	do
+	{
+		sessionToken = (unsigned int)rand() << 16 ^ (unsigned int)rand();
+	} while (sessionToken == 0);
+
+	// Generate a new seed for the kick generators, so every match has different kicks.
+	std::random_device device;
+	matchSeed = (sf::Uint64)device() << 32 ^ device();
+
+	sf::Packet packet;
+	unsigned short type = SESSION;
+	packet << type << sessionToken << teamSize << matchSeed;
+
+	if (tcpSocket->send(packet) != sf::Socket::Done)
+	{
+		// Error
+	}
+}
+
+// Send the session token back to the host to resume the match.
+void NetworkManager::sendResume()
+{
+	sf::Packet packet;
+	unsigned short type = RESUME;
+	packet << type << sessionToken;
+
+	if (tcpSocket->send(packet) != sf::Socket::Done)
+	{
+		// Error
+	}
+}
+
+// Send everything the client needs to carry on from where the host is: time, score, goal reset, ball, kick generators, and the host's team.
+void NetworkManager::sendSnapshot()
+{
+	sf::Packet packet;
+	unsigned short type = SNAPSHOT;
+	Ball* ball = objectManager->getBall();
+	sf::Vector2f ballPosition = ball->getPositionXY();
+	sf::Vector2f ballVelocity = ball->getVelocity();
+
+	packet << type << objectManager->getTime() << objectManager->getLeftScore() << objectManager->getRightScore() << objectManager->getGoalScored() << objectManager->getResetTimer()
+		<< ballPosition.x << ballPosition.y << ballVelocity.x << ballVelocity.y
+		<< objectManager->getKickRandom(0)->getState() << objectManager->getKickRandom(1)->getState();
+
+	for (int i = 0; i < objectManager->getPlayerCount(); i++)
+	{
+		if (objectManager->isOwnPlayer(i))
+		{
+			Player* player = objectManager->getPlayer(i);
+			sf::Vector2f position = player->getPosition();
+			sf::Vector2f velocity = player->getVelocity();
+			packet << position.x << position.y << velocity.x << velocity.y << player->getKicking();
+		}
+	}
+
+	if (tcpSocket->send(packet) != sf::Socket::Done)
+	{
+		// Error
+	}
+}
+
+// Host checks the session token sent by a reconnecting client, and replies with a snapshot if it matches. Returns whether the session was resumed.
+bool NetworkManager::handleResume(sf::Packet packet)
+{
+	unsigned int token;
+	if (!isHost || gameState->getCurrentState() != State::LEVEL || !(packet >> token) || token != sessionToken)
+	{
+		return false;
+	}
+
+	std::cout << "Session resumed.\n";
+	sendSnapshot();
+	reconnecting = false;
+	reconnectSocketLost = false;
+	return true;
+}
+
+// Client carries on from the host's snapshot.
+void NetworkManager::handleSnapshot(sf::Packet packet)
+{
+	float time;
+	int leftScore;
+	int rightScore;
+	bool goalScored;
+	float resetTimer;
+	sf::Vector2f ballPosition;
+	sf::Vector2f ballVelocity;
+	sf::Uint64 leftKicks;
+	sf::Uint64 rightKicks;
+
+	if (!(packet >> time >> leftScore >> rightScore >> goalScored >> resetTimer
+		>> ballPosition.x >> ballPosition.y >> ballVelocity.x >> ballVelocity.y >> leftKicks >> rightKicks))
+	{
+		return;
+	}
+
+	std::cout << "Session resumed.\n";
+
+	// The snapshot is half a round trip old by the time it arrives.
+	float latency = float(pingValue) / 2000;
+	objectManager->setTime(time + latency);
+	objectManager->setScore(leftScore, rightScore);
+	objectManager->setGoalScored(goalScored);
+	objectManager->setResetTimer(resetTimer);
+
+	// Carry on drawing kick powers from where the host is, in case kicks were missed while disconnected.
+	objectManager->getKickRandom(0)->setState(leftKicks);
+	objectManager->getKickRandom(1)->setState(rightKicks);
+
+	// Move the ball to where the host has it, in the same way as a collision.
+	setBallState(time, ballPosition, ballVelocity);
+
+	// Move the host's team.
+	for (int i = 0; i < objectManager->getPlayerCount(); i++)
+	{
+		if (objectManager->isOwnPlayer(i))
+		{
+			continue;
+		}
+
+		sf::Vector2f position;
+		sf::Vector2f velocity;
+		bool kicking;
+		if (!(packet >> position.x >> position.y >> velocity.x >> velocity.y >> kicking))
+		{
+			break;
+		}
+
+		streams[i].mostRecentPositionTime = time;
+		streams[i].mostRecentPosition = position;
+		streams[i].mostRecentVelocity = velocity;
+		objectManager->getPlayer(i)->setKicking(kicking);
+		objectManager->getPlayer(i)->setPosition(position);
+	}
+	lastPositionReceiveTime = getSystemTime();
+
+	reconnecting = false;
+	reconnectSocketLost = false;
+}
+
 // Tick function - run game tick amount of times a second and handles various aspects of the game's networking.
 void NetworkManager::tick()
 {
+	// Keep trying to resume the session if the connection has been lost.
+	if (reconnecting)
+	{
+		updateReconnect();
+	}
+
+	// Keep registering our UDP endpoint with the relay until it confirms it, whether or not we have been paired.
+	if (viaRelay && !relayRegistered)
+	{
+		sendRelayJoinUDP();
+	}
+
 	// If in the lobby, run the lobby tick function.
 	if (gameState->getCurrentState() == State::LOBBY)
 	{
@@ -177,20 +764,46 @@ void NetworkManager::tick()
 // Lobby tick - handles host connection and ready statuses.
 void NetworkManager::lobbyTick()
 {
-	if (isHost && !connected)
+	if (isHost && !connected && relayConfigured)
+	{
+		// Join the relay with a new match code for the client to enter. If the relay can't be reached, host directly instead.
+		if (connectState == CONNECT_FAILED)
+		{
+			std::cout << "Could not reach relay, hosting directly.\n";
+			relayConfigured = false;
+			connectState = NOT_CONNECTING;
+		}
+		else if (!viaRelay && connectState == NOT_CONNECTING)
+		{
+			connectRelay(rand() % 90000 + 10000);
+		}
+	}
+	else if (isHost && !connected)
 	{
+		// Register with the matchmaker so clients can find this game. Registers again if no client has connected since being matched.
+		if (matchmakerConfigured && !matchmaking && getSystemTime() > matchmakerRetryTime)
+		{
+			registerHost();
+		}
+
 		// Check if anyone is trying to connect.
-		if (tcpListener.accept(tcpSocket) != sf::Socket::Done)
+		if (tcpListener.accept(*tcpSocket) != sf::Socket::Done)
 		{
 			// Error - no connection made.
 		}
 		else
 		{
-			// Successfully connected. Set IP, port and send selected character to client.
+			// Successfully connected. Leave the matchmaker's queue, set IP, port and send selected character to client.
 			std::cout << "Client connected.\n";
+			if (matchmaking)
+			{
+				matchmakerSocket.disconnect();
+				matchmaking = false;
+			}
 			connected = true;
-			recipientIP = tcpSocket.getRemoteAddress();
-			recipientPort = tcpSocket.getRemotePort();
+			recipientIP = tcpSocket->getRemoteAddress();
+			recipientPort = tcpSocket->getRemotePort();
+			sendSession();
 			sendCharacter(lobby->getHostChar());
 		}
 	}
@@ -217,8 +830,14 @@ void NetworkManager::lobbyTick()
 
 void NetworkManager::gameTick()
 {
-	// Send player's position.
-	sendPosition();
+	// Send the position of each of this client's players.
+	for (int i = 0; i < objectManager->getPlayerCount(); i++)
+	{
+		if (objectManager->isOwnPlayer(i))
+		{
+			sendPosition(i);
+		}
+	}
 	if (toSendCollision) // Check if a collision is in queue to be sent. By sending packet on tick instead of when the collision happens, it improves performance as less bandwidth is used. 
 	{
 		sendBallCollision();
@@ -226,20 +845,30 @@ void NetworkManager::gameTick()
 
 	// Handle UDP packets that were received outside of the tick function.
 	handleUDP();
+
+	// When connected directly, the host accepts a reconnecting client at any point during the match, as the host may not have noticed the old connection dropping.
+	if (isHost && !relayConfigured)
+	{
+		acceptResume();
+	}
 	
 	
 
-	// After handling packets, get the other player's most recent position, and put it to the front of the most recent positions list.
-	positionHistory.push_front(mostRecentPosition);
-	velocityHistory.push_front(mostRecentVelocity);
-	positionTimes.push_front(mostRecentPositionTime);
-
-	// Only keep last 3 positions.
-	if (positionHistory.size() > 3)
+	// After handling packets, get each of the other team's most recent position, and put it to the front of their history. Only the last 3 positions are kept.
+	for (int i = 0; i < objectManager->getPlayerCount(); i++)
 	{
-		positionHistory.pop_back();
-		velocityHistory.pop_back();
-		positionTimes.pop_back();
+		PlayerStream& stream = streams[i];
+		for (int j = 2; j > 0; j--)
+		{
+			stream.positionHistory[j] = stream.positionHistory[j - 1];
+			stream.velocityHistory[j] = stream.velocityHistory[j - 1];
+			stream.positionTimes[j] = stream.positionTimes[j - 1];
+		}
+
+		stream.positionHistory[0] = stream.mostRecentPosition;
+		stream.velocityHistory[0] = stream.mostRecentVelocity;
+		stream.positionTimes[0] = stream.mostRecentPositionTime;
+		stream.historyCount = std::min(stream.historyCount + 1, 3);
 	}
 }
 
@@ -251,8 +880,19 @@ void NetworkManager::receiveTCP()
 	// Type of packet received. Type is always at the front of packets when they are sent.
 	unsigned short type;
 
+	// Check on any connection attempts and handle any replies from the matchmaker first.
+	if (connectState == CONNECTING)
+	{
+		updateConnect();
+	}
+
+	if (matchmaking)
+	{
+		receiveMatchmaker();
+	}
+
 	// Attempt to receive packets until there are no more packets to receive.
-	while (tcpSocket.receive(packet) == sf::Socket::Done)
+	while (tcpSocket->receive(packet) == sf::Socket::Done)
 	{
 		// Extract type from packet.
 		packet >> type;
@@ -286,6 +926,66 @@ void NetworkManager::receiveTCP()
 		case CHARACTER:
 			lobby->setOpponentChar(packet);
 			break;
+		case RELAY_PAIRED:
+			// The relay has paired us with the other player. All packets go through the relay, so it is treated as the recipient.
+			std::cout << "Paired through relay.\n";
+			awaitingRelayPair = false;
+			reconnectSocketLost = false;
+			connected = true;
+			recipientIP = relayIP;
+			recipientPort = relayPort;
+			isUdpSetup = true;
+
+			// If paired again while resuming a match, the client sends its session token instead of starting over.
+			if (reconnecting)
+			{
+				if (!isHost)
+				{
+					sendResume();
+				}
+				break;
+			}
+
+			if (isHost)
+			{
+				sendSession();
+			}
+			sendCharacter(isHost ? lobby->getHostChar() : lobby->getClientChar());
+			break;
+		case RELAY_REGISTERED:
+			// The relay knows our UDP endpoint, so datagrams can go through it.
+			relayRegistered = true;
+			break;
+		case RELAY_REJECTED:
+			// The relay turned the join away, as someone else has this side of the match. The relay closes the connection.
+			std::cout << "Relay match " << relayMatchID << " is already full.\n";
+			awaitingRelayPair = false;
+			viaRelay = false;
+			tcpSocket->disconnect();
+
+			// While resuming, try again once the relay has noticed the old connection has gone. In the lobby, the host picks a new match code and the client is told the match can't be joined.
+			if (reconnecting)
+			{
+				reconnectSocketLost = true;
+			}
+			else if (!isHost)
+			{
+				connectState = CONNECT_FAILED;
+			}
+			break;
+		case RELAY_PEER_LEFT:
+			// The other player has left the relay. Stay joined so that the relay can pair us again, and wait for them to resume if in a match.
+			connectionLost(false);
+			break;
+		case SESSION:
+			packet >> sessionToken >> teamSize >> matchSeed;
+			break;
+		case RESUME:
+			handleResume(packet);
+			break;
+		case SNAPSHOT:
+			handleSnapshot(packet);
+			break;
 		default:
 			break;
 		}
@@ -346,39 +1046,33 @@ void NetworkManager::handleUDP()
 
 void NetworkManager::runPrediction(float dt)
 {
-	if (positionHistory.size() < 3)
+	if (reconnecting && getSystemTime() - lastPositionReceiveTime > maxExtrapolationTime * 1000)
 	{
-		// Don't run prediction if don't have full history list.
+		// Stop moving the other team once their updates have stopped for a while, otherwise they would carry on across the pitch.
 		return;
 	}
 
-	sf::Vector2f pos[3];
-	sf::Vector2f vel[3];
-	float time[3];
-
-	// Get positions from list.
-	int i = 0;
-	for (std::list<sf::Vector2f>::iterator it = positionHistory.begin(); it != positionHistory.end(); ++it)
+	for (int i = 0; i < objectManager->getPlayerCount(); i++)
 	{
-		pos[i] = sf::Vector2f(it->x, it->y);
-		i++;
+		if (!objectManager->isOwnPlayer(i))
+		{
+			runPrediction(i, dt);
+		}
 	}
+}
 
-	// Get position times from list.
-	i = 0;
-	for (std::list<float>::iterator it = positionTimes.begin(); it != positionTimes.end(); ++it)
+void NetworkManager::runPrediction(int player, float dt)
+{
+	PlayerStream& stream = streams[player];
+	if (stream.historyCount < 3)
 	{
-		time[i] = *it;
-		i++;
+		// Don't run prediction if don't have full history list.
+		return;
 	}
 
-	// Get velocities from list.
-	i = 0;
-	for (std::list<sf::Vector2f>::iterator it = velocityHistory.begin(); it != velocityHistory.end(); ++it)
-	{
-		vel[i] = *it;
-		i++;
-	}
+	// Velocities from the history, most recent first. The unused methods below would also need pos = stream.positionHistory and time = stream.positionTimes.
+	sf::Vector2f* vel = stream.velocityHistory;
+	Player* otherPlayer = objectManager->getPlayer(player);
 	
 	// Linear prediction - predict where the other player will move based on their current velocity. 
 	otherPlayer->setPosition(otherPlayer->getPosition().x + vel[0].x * dt, otherPlayer->getPosition().y + vel[0].y * dt);
@@ -436,11 +1130,14 @@ void NetworkManager::runPrediction(float dt)
 void NetworkManager::resetPositionData()
 {
 	// Reset all position related values to default.
-	mostRecentPositionTime = 0;
 	mostRecentBallCollisionTime = 0;
-	positionHistory.clear();
-	velocityHistory.clear();
-	positionTimes.clear();
+	for (int i = 0; i < streams.size(); i++)
+	{
+		streams[i].mostRecentPositionTime = 0;
+		streams[i].mostRecentPosition = sf::Vector2f(0, 0);
+		streams[i].mostRecentVelocity = sf::Vector2f(0, 0);
+		streams[i].historyCount = 0;
+	}
 	receivedPackets.clear();
 }
 
@@ -456,7 +1153,7 @@ void NetworkManager::syncTime()
 	long long syncTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 	packet << type << syncTime;
 
-	if (tcpSocket.send(packet))
+	if (tcpSocket->send(packet))
 	{
 		// Error.
 	}
@@ -496,7 +1193,7 @@ void NetworkManager::syncCountdown()
 	long long syncTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 	packet << type << syncTime;
 
-	if (tcpSocket.send(packet))
+	if (tcpSocket->send(packet))
 	{
 		// Error.
 	}
@@ -526,17 +1223,20 @@ void NetworkManager::syncCountdown(sf::Packet packet)
 }
 // ----
 
-// Function for sending position, velocity and kicking status to the other player.
-void NetworkManager::sendPosition()
+// Function for sending one of this client's players' position, velocity and kicking status to the other player.
+void NetworkManager::sendPosition(int player)
 {
-	// Setup packet with type, position, time, velocity, and kicking status.
+	// Setup packet with type, player, position, time, velocity, kicking status, and how long ago the user's newest press was read (-1 if there wasn't one, or for players the user doesn't control).
 	sf::Packet packet;
 	unsigned short type = POSITION;
-	sf::Vector2f position = controlledPlayer->getPosition();
+	sf::Uint8 index = player;
+	Player* p = objectManager->getPlayer(player);
+	sf::Vector2f position = p->getPosition();
 	float time = objectManager->getTime();
-	sf::Vector2f velocity = controlledPlayer->getVelocity();
-	bool kicking = controlledPlayer->getKicking();
-	packet << type << time << position.x << position.y << velocity.x << velocity.y << kicking;
+	sf::Vector2f velocity = p->getVelocity();
+	bool kicking = p->getKicking();
+	sf::Int32 inputAge = p == objectManager->getControlledPlayer() ? LatencyProbe::getShared().takeInputAge() : -1;
+	packet << type << index << time << position.x << position.y << velocity.x << velocity.y << kicking << inputAge;
 
 	// Send packet.
 	if (udpSocket.send(packet, recipientIP, recipientPort))
@@ -554,20 +1254,29 @@ void NetworkManager::sendPosition()
 void NetworkManager::receivePosition(sf::Packet packet)
 {
 	// Variables to receive from packet.
+	sf::Uint8 index;
 	sf::Vector2f position;
 	sf::Vector2f velocity;
 	float time;
 	bool kicking;
+	sf::Int32 inputAge;
+
+	// Retrieve data from packet. Ignore players that aren't in the match or belong to this client.
+	if (!(packet >> index >> time >> position.x >> position.y >> velocity.x >> velocity.y >> kicking >> inputAge) || index >= objectManager->getPlayerCount() || objectManager->isOwnPlayer(index))
+	{
+		return;
+	}
 
-	// Retrieve data from packet.
-	packet >> time >> position.x >> position.y >> velocity.x >> velocity.y >> kicking;
+	PlayerStream& stream = streams[index];
+	Player* otherPlayer = objectManager->getPlayer(index);
 
-	if (time > mostRecentPositionTime) // Use the most recent position packet's data.
+	if (time > stream.mostRecentPositionTime) // Use the most recent position packet's data.
 	{
 		// Set most recent values.
-		mostRecentPositionTime = time;
-		mostRecentPosition = position;
-		mostRecentVelocity = velocity;
+		stream.mostRecentPositionTime = time;
+		lastPositionReceiveTime = getSystemTime();
+		stream.mostRecentPosition = position;
+		stream.mostRecentVelocity = velocity;
 
 		// Determine direction based on velocity. The player's direction could have been sent with the packet, but working out direction locally saves bandwidth.
 		if (velocity.x > 0)
@@ -583,7 +1292,13 @@ void NetworkManager::receivePosition(sf::Packet packet)
 		otherPlayer->setKicking(kicking);
 
 		// Set position.
-		otherPlayer->setPosition(mostRecentPosition);
+		otherPlayer->setPosition(stream.mostRecentPosition);
+
+		// Measure the other user's press from here on, taking half the ping as the time the packet took to arrive.
+		if (inputAge >= 0)
+		{
+			LatencyProbe::getShared().remoteInputReceived(inputAge, float(pingValue) / 2);
+		}
 	}
 }
 
@@ -595,21 +1310,23 @@ void NetworkManager::setBallCollision(sf::Vector2f pos, sf::Vector2f vel)
 	collisionPos = pos;
 	collisionVel = vel;
 	collisionTime = objectManager->getTime();
+	collisionKickState = objectManager->getKickRandom(isHost ? 0 : 1)->getState();
 }
 
 // Function to send collision details.
 void NetworkManager::sendBallCollision()
 {
-	// Setup packet with type, time, ball position, and ball velocity.
+	// Setup packet with type, time, ball position, ball velocity, and this team's kick generator state. Only the latest collision is sent each tick, so the state is sent rather than a count of kicks.
 	sf::Packet packet;
 	unsigned short type = BALL_COLLISION;
 	float time = collisionTime;
 	sf::Vector2f position = collisionPos;
 	sf::Vector2f velocity = collisionVel;
-	packet << type << time << position.x << position.y << velocity.x << velocity.y;
+	sf::Uint64 kickState = collisionKickState;
+	packet << type << time << position.x << position.y << velocity.x << velocity.y << kickState;
 
 	// Send packet.
-	if (tcpSocket.send(packet) != sf::Socket::Done)
+	if (tcpSocket->send(packet) != sf::Socket::Done)
 	{
 		// Error
 	}
@@ -629,49 +1346,57 @@ void NetworkManager::handleBallCollision(sf::Packet packet)
 	float time;
 	sf::Vector2f position;
 	sf::Vector2f velocity;
+	sf::Uint64 kickState;
 
-	packet >> time >> position.x >> position.y >> velocity.x >> velocity.y;
+	packet >> time >> position.x >> position.y >> velocity.x >> velocity.y >> kickState;
 	// ----
 
+	// The other team may have drawn several kick powers since their last collision was sent, so carry on from where their generator is now. Packets arrive in order over TCP, so this is always the newest state.
+	objectManager->otherTeamKicked(kickState);
+
 	// Check if it's the most recent collision.
 	if (time > mostRecentBallCollisionTime)
 	{
-		// Set new most recent time if it is.
-		mostRecentBallCollisionTime = time;
+		setBallState(time, position, velocity);
 
-		// Get pointer to the ball.
-		Ball* ball = objectManager->getBall();
+		// Play kicking sound.
+		audio->playSoundbyName("kick");
+	}
+}
 
-		// Time that has passed since the collision.
-		float latency = objectManager->getTime() - time;
+// Move the ball to where it was at the given time, then simulate it forward to the current time. The ball interpolates from where it was drawn, so it doesn't jump.
+void NetworkManager::setBallState(float time, sf::Vector2f position, sf::Vector2f velocity)
+{
+	// Set new most recent time.
+	mostRecentBallCollisionTime = time;
 
-		// Save ball position from before the collision.
-		sf::Vector2f previousPos = ball->getPosition();
+	// Get pointer to the ball.
+	Ball* ball = objectManager->getBall();
 
-		// Set the ball's position to where the collision occured, and set velocity.
-		ball->setPositionXY(position.x, position.y);
-		ball->setVelocity(velocity.x, velocity.y);
+	// Time that has passed since the collision.
+	float latency = objectManager->getTime() - time;
 
-		// Set time simulated to 0, and how much the simulation is going to be incremented.
-		float simTime = 0;
-		float simIncrement = objectManager->getPhysicsStep();
-		
-		while (simTime < latency) // Simulate ahead to check if the ball is going to collide with anything.
-		{
-			objectManager->checkBallCollision();
-			ball->update(simIncrement);
-			simTime += simIncrement;
-		}
+	// Save ball position from before the collision.
+	sf::Vector2f previousPos = ball->getPosition();
 
-		// Set lagged position to the position before the collision.
-		ball->setLagPosition(previousPos.x, previousPos.y);
+	// Set the ball's position to where the collision occured, and set velocity.
+	ball->setPositionXY(position.x, position.y);
+	ball->setVelocity(velocity.x, velocity.y);
 
-		// Tell the ball to interpolate
-		ball->setInterpolating(true);
-		
-		// Play kicking sound.
-		audio->playSoundbyName("kick");
+	// Move the ball ahead by the time that has passed, bouncing off anything it reaches. The ball's path is worked out contact to contact, so this costs the same however high the latency is.
+	// Posts hit along the way play their sound now, late, rather than not at all.
+	if (latency > 0)
+	{
+		objectManager->checkBallCollision();
+		ball->advance(latency);
+		objectManager->playBallContactSounds();
 	}
+
+	// Set lagged position to the position before the collision.
+	ball->setLagPosition(previousPos.x, previousPos.y);
+
+	// Tell the ball to interpolate
+	ball->setInterpolating(true);
 }
 
 // Send goal function. Only the host will send this - their simulation is treated as the 'correct' one.
@@ -687,7 +1412,7 @@ void NetworkManager::sendGoal(Side s)
 	// Send packet.
 	if (connected)
 	{
-		if (tcpSocket.send(packet))
+		if (tcpSocket->send(packet))
 		{
 			// Error.
 		}
@@ -732,7 +1457,7 @@ void NetworkManager::sendReadyState(bool ready)
 	unsigned short type = READY;
 	packet << type << ready;
 
-	if (tcpSocket.send(packet) != sf::Socket::Done)
+	if (tcpSocket->send(packet) != sf::Socket::Done)
 	{
 		// Error.
 	}
@@ -773,7 +1498,7 @@ void NetworkManager::sendCharacter(int n)
 	packet << type << n;
 
 	// Send packet.
-	if (tcpSocket.send(packet) != sf::Socket::Done)
+	if (tcpSocket->send(packet) != sf::Socket::Done)
 	{
 		// Error
 	}
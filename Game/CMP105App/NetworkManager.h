@@ -7,6 +7,11 @@
 #include "Lobby.h"
 #include "Player.h"
 #include <deque>
+#include <vector>
+#include <memory>
+#include <future>
+#include <random>
+#include <ctime>
 
 class ObjectManager;
 class Lobby;
@@ -20,6 +25,13 @@ public:
 	// Enum for which side has scored a goal.
 	enum Side { LEFT = 0, RIGHT };
 
+	// Enum for the state of a connection attempt. Once connected, getConnected() returns true.
+	enum ConnectState { NOT_CONNECTING = 0, CONNECTING, CONNECT_FAILED };
+
+	// Enum for the different types of packets that will be sent. Public so that the relay and matchmaking servers can recognise the packets they need to handle.
+	enum PacketType { PING = 0, PONG, READY, POSITION, BALL_COLLISION, TIME_SYNC, COUNTDOWN_SYNC, GOAL, CHARACTER, RELAY_JOIN, RELAY_PAIRED, RELAY_PEER_LEFT,
+		MATCHMAKER_REGISTER, MATCHMAKER_REQUEST, MATCHMAKER_PROBE, MATCHMAKER_MATCH, SESSION, RESUME, SNAPSHOT, RELAY_REJECTED, RELAY_REGISTERED, END };
+
 	// Setup pointers.
 	void init(GameState* gs, Lobby* l, ObjectManager* om, AudioManager* a);
 
@@ -49,15 +61,19 @@ public:
 		return connected;
 	};
 
+	// True while the connection has been lost during a match and is being resumed.
+	bool getReconnecting()
+	{
+		return reconnecting;
+	};
+
 	std::string getMyLocalIP()
 	{
 		return myLocalIP.toString();
 	};
 
-	std::string getMyPublicIP()
-	{
-		return myPublicIP.toString();
-	}
+	// The public IP is looked up in the background, so it may not be known yet.
+	std::string getMyPublicIP();
 
 	std::string getRecipientIP()
 	{
@@ -87,6 +103,54 @@ public:
 	{
 		return isHost;
 	};
+
+	// Number of players on each team. Chosen by the host and sent to the client with the session.
+	int getTeamSize()
+	{
+		return teamSize;
+	};
+
+	// Seed for the match's kick generators. Chosen by the host and sent to the client with the session.
+	sf::Uint64 getMatchSeed()
+	{
+		return matchSeed;
+	};
+
+	bool getRelayConfigured()
+	{
+		return relayConfigured;
+	};
+
+	unsigned int getRelayMatchID()
+	{
+		return relayMatchID;
+	};
+
+	bool getMatchmakerConfigured()
+	{
+		return matchmakerConfigured;
+	};
+
+	bool getMatchmaking()
+	{
+		return matchmaking;
+	};
+
+	ConnectState getConnectState()
+	{
+		return connectState;
+	};
+
+	// Time in seconds since the current connection attempt started, and how long it can take before giving up.
+	float getConnectTime()
+	{
+		return float(getSystemTime() - connectStartTime) / 1000;
+	};
+
+	float getConnectTimeout()
+	{
+		return connectTimeout;
+	};
 	// ----
 
 	// Setter functions.
@@ -96,21 +160,51 @@ public:
 		isHost = host;
 	};
 
-	void setControlledPlayer(Player* player)
+	// Set from the command line. Only the host's team size is used.
+	void setTeamSize(int size)
+	{
+		teamSize = size;
+	};
+
+	void setConnectTimeout(float seconds)
 	{
-		controlledPlayer = player;
+		connectTimeout = seconds;
 	};
 
-	void setOtherPlayer(Player* player)
+	// Called once a failed connection attempt has been dealt with.
+	void resetConnectState()
 	{
-		otherPlayer = player;
+		connectState = NOT_CONNECTING;
+	};
+
+	// Sets the relay server to use instead of connecting directly. Set from the command line.
+	void setRelay(sf::IpAddress IP, int port)
+	{
+		relayIP = IP;
+		relayPort = port;
+		relayConfigured = true;
+	};
+
+	// Sets the matchmaking server used to find matches instead of entering an IP and port. Set from the command line.
+	void setMatchmaker(sf::IpAddress IP, int port)
+	{
+		matchmakerIP = IP;
+		matchmakerPort = port;
+		matchmakerConfigured = true;
 	};
 	// ----
 
-	// Connect and disconnect functions.
-	bool connect(sf::IpAddress IP, int port);
+	// Connect and disconnect functions. Connecting doesn't block - check getConnectState() and getConnected() for the result.
+	void connect(sf::IpAddress IP, int port);
+	void connect(const std::vector<sf::IpAddress>& addresses, int port);
 	void disconnect();
 
+	// Join a match on the relay server. Both the host and the client connect outbound to the relay, and are connected once the relay has paired them.
+	void connectRelay(unsigned int matchID);
+
+	// Ask the matchmaker for a match. Once a host has been found, connect() is called with the host's details.
+	bool findMatch();
+
 	// Function to check if both players are ready.
 	bool getReadyStatus();
 
@@ -130,8 +224,9 @@ public:
 	void receiveTCP();
 	void receiveUDP();
 
-	// Functions for predicting the other players movement, and resetting the data that is used for these predictions.
+	// Functions for predicting the other team's movement, and resetting the data that is used for these predictions.
 	void runPrediction(float dt);
+	void runPrediction(int player, float dt);
 	void resetPositionData();
 
 	// Functions for syncing time between clients.
@@ -139,24 +234,51 @@ public:
 	void syncCountdown();
 	
 private:
-	// Enum for the different types of packets that will be sent.
-	enum PacketType { PING = 0, PONG, READY, POSITION, BALL_COLLISION, TIME_SYNC, COUNTDOWN_SYNC, GOAL, CHARACTER, END };
-
 	// Response to receiving a ping packet.
 	void pong();
 	
+	// Functions for checking on connection attempts, and finishing connecting once one succeeds.
+	void updateConnect();
+	void onConnected();
+
+	// Function to get the current system time in milliseconds.
+	long long getSystemTime()
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	};
+
+	// Register the host with the matchmaker, and handle packets from the matchmaker.
+	bool sendToMatchmaker(sf::Packet& packet);
+	bool registerHost();
+	void receiveMatchmaker();
+
+	// Send the UDP half of the relay join, so that the relay knows where to forward datagrams.
+	void sendRelayJoinUDP();
+
+	// Functions for resuming a match after the connection has been lost. The host gives the client a session token when they connect, and the client sends it back when reconnecting.
+	// Once the host has checked the token, it sends the client a snapshot of the match to carry on from.
+	void connectionLost(bool socketLost);
+	void updateReconnect();
+	void acceptResume();
+	void sendSession();
+	void sendResume();
+	void sendSnapshot();
+	bool handleResume(sf::Packet packet);
+	void handleSnapshot(sf::Packet packet);
+
 	// Different tick functions for use depending on game state.
 	void lobbyTick();
 	void gameTick();
 
-	// Functions for sending and receiving position data.
-	void sendPosition();
+	// Functions for sending and receiving position data. Each player is sent separately, with its index.
+	void sendPosition(int player);
 	void receivePosition(sf::Packet packet);
 
 	// Functions for handling incoming packets.
 	void handleUDP();
 	void handleGoal(sf::Packet packet);
 	void handleBallCollision(sf::Packet packet);
+	void setBallState(float time, sf::Vector2f position, sf::Vector2f velocity);
 	void receiveReadyState(sf::Packet packet);
 	void syncTime(sf::Packet packet);
 	void syncCountdown(sf::Packet packet);
@@ -167,26 +289,72 @@ private:
 	ObjectManager* objectManager;
 	AudioManager* audio;
 
-	// Pointers to the player objects.
-	Player* controlledPlayer;
-	Player* otherPlayer;
-
-	// TCP socket and listener. Used for most communication.
-	sf::TcpSocket tcpSocket;
+	// TCP socket and listener. Used for most communication. The socket is a pointer so that whichever connection attempt succeeds first can take its place.
+	std::unique_ptr<sf::TcpSocket> tcpSocket;
 	sf::TcpListener tcpListener;
 
+	// Sockets for connection attempts that are still in progress, and the state of the attempt.
+	std::vector<std::unique_ptr<sf::TcpSocket>> connectAttempts;
+	ConnectState connectState;
+	float connectTimeout;
+	long long connectStartTime;
+	bool connectingToRelay;
+
 	// UDP socket. Used for position updates.
 	sf::UdpSocket udpSocket;
 
-	// Information about user's IP and port.
+	// Information about user's IP and port. Finding the public IP means asking an external website, so it is done in the background and the result is saved once it arrives.
 	sf::IpAddress myLocalIP;
 	sf::IpAddress myPublicIP;
+	std::future<sf::IpAddress> publicIPLookup;
+	bool publicIPReady;
 	unsigned short myPort;
 
 	// Information about other player's IP and port.
 	sf::IpAddress recipientIP;
 	unsigned short recipientPort;
 
+	// Information about the relay server, if one is being used.
+	sf::IpAddress relayIP;
+	unsigned short relayPort;
+	unsigned int relayMatchID;
+	bool relayConfigured;
+	bool viaRelay;
+
+	// Set once joined to the relay until it pairs us or turns the join away, so that a reconnect isn't tried again while waiting for the other player.
+	bool awaitingRelayPair;
+
+	// Set once the relay has confirmed it knows our UDP endpoint. Until then the UDP join is sent every tick, as pairing happens over TCP and says nothing about UDP.
+	bool relayRegistered;
+
+	// Connection to the matchmaking server, if one is being used. The host registers again if it hasn't been connected to by the retry time.
+	sf::TcpSocket matchmakerSocket;
+	sf::IpAddress matchmakerIP;
+	unsigned short matchmakerPort;
+	bool matchmakerConfigured;
+	bool matchmaking;
+	long long matchmakerRetryTime;
+
+	// Request to send to the matchmaker once connected.
+	sf::Packet matchmakerRequest;
+	bool matchmakerRequestPending;
+	long long matchmakerConnectTime;
+
+	// Session used to resume a match. While reconnecting, the match keeps running for the grace period before giving up and returning to the lobby.
+	// The socket a reconnecting client is accepted on only replaces the current connection once the client has sent the right token.
+	unsigned int sessionToken;
+	bool reconnecting;
+	bool reconnectSocketLost;
+	long long reconnectStartTime;
+	long long reconnectRetryTime;
+	float gracePeriod;
+	std::unique_ptr<sf::TcpSocket> resumeSocket;
+	long long resumeAcceptTime;
+
+	// How long the other player is extrapolated for after their last position update, so they don't drift off while the connection is down.
+	float maxExtrapolationTime;
+	long long lastPositionReceiveTime;
+
 	// Rate at which the game ticks and rate at which the game pings the other player.
 	int tickRate;
 	int pingRate;
@@ -212,17 +380,32 @@ private:
 	float collisionTime;
 	float mostRecentBallCollisionTime;
 
-	// Details about the most recent position received.
-	float mostRecentPositionTime;
-	sf::Vector2f mostRecentPosition;
-	sf::Vector2f mostRecentVelocity;
+	// State of this client's team's kick generator after the most recent collision, sent with it so the other client's copy stays in step.
+	sf::Uint64 collisionKickState;
+
+	// Position updates received for one of the other client's players. The most recent update is added to the front of the history each tick, and the last 3 are kept for prediction.
+	struct PlayerStream
+	{
+		float mostRecentPositionTime;
+		sf::Vector2f mostRecentPosition;
+		sf::Vector2f mostRecentVelocity;
+		int historyCount;
+		sf::Vector2f positionHistory[3];
+		sf::Vector2f velocityHistory[3];
+		float positionTimes[3];
+	};
+
+	// One stream for each player slot, indexed the same as the object manager's players. Only the other team's are used.
+	std::vector<PlayerStream> streams;
+
+	// Number of players on each team.
+	int teamSize;
+
+	// Seed for the match's kick generators.
+	sf::Uint64 matchSeed;
 
 	// Received packets stored in deque so you can add or remove at both ends.
-	// Received position details stored in a list.
 	std::deque<sf::Packet> receivedPackets;
-	std::list<sf::Vector2f> positionHistory;
-	std::list<sf::Vector2f> velocityHistory;
-	std::list<float> positionTimes;
 	
 	
 };
@@ -1,15 +1,20 @@
 #include "ObjectManager.h"
 
-ObjectManager::ObjectManager()
+ObjectManager::ObjectManager() : grid(sf::Vector2f(1200, 675), 150)
 {
-	// Load font.
-	font.loadFromFile("font/arial.ttf");
-
-	// Load character textures.
-	messi.loadFromFile("gfx/messi.png");
-	ronaldo.loadFromFile("gfx/ronaldo.png");
-	kirby.loadFromFile("gfx/kirby.png");
-	miedema.loadFromFile("gfx/miedema.png");
+	// Get font from the shared cache.
+	font = ResourceCache::getShared().getFont("font/arial.ttf");
+
+	// Load the atlas with the ball, goalpost and character sprites in the background, then set up the sprites once it is on the GPU.
+	AssetLoader::getShared().queue([this]()
+	{
+		atlas.loadImage(TextureAtlas::matchSprites);
+	},
+	[this]()
+	{
+		atlas.upload();
+		setupSprites();
+	});
 	
 	// Set default values.
 	// ----
@@ -18,6 +23,7 @@ ObjectManager::ObjectManager()
 
 	physicsStep = 1.0f/180.0f; // High physics rate to ensure smooth movement and timely collisions.
 	physicsTimer = 0;
+	maxPhysicsSteps = 8;
 
 	goalScored = false;
 	resetLength = 2;
@@ -25,44 +31,60 @@ ObjectManager::ObjectManager()
 	
 	gameLength = 90;
 	gameTimer = 0;
+
+	teamSize = 1;
+	ownsLeftTeam = true;
+	ownsAllPlayers = false;
+
+	batchSprites = true;
 	// ----
 
 	// Setup ball.
-	ballSprite.loadFromFile("gfx/football.png");
-	ball.setTexture(&ballSprite);
 	ball.setSize(sf::Vector2f(50, 50));
 	ball.setOrigin(ball.getSize().x / 2, ball.getSize().y / 2);
 	ball.setCollisionBox(-ball.getSize().x / 2, -ball.getSize().y / 2, ball.getSize().x, ball.getSize().y);
 
+	// Setup players. Every player slot is created up front, so pointers to them stay valid whatever the team size.
+	players.resize(maxTeamSize * 2);
+	for (int i = 0; i < players.size(); i++)
+	{
+		players[i].setSize(sf::Vector2f(100, 100));
+		players[i].setCollisionBox(0, 0, players[i].getSize().x, players[i].getSize().y);
+	}
+	controlledPlayer = &players[0];
+
+	// Add physics bodies. The ball's position and velocity live in the physics world, and the players are copied into it.
+	ballBody = world.addBody(ball.getCollisionBox(), 0);
+	ball.setBody(&world, ballBody);
+	world.setAdvanceStep(physicsStep);
+	firstPlayerBody = world.getBodyCount();
+	for (int i = 0; i < players.size(); i++)
+	{
+		world.addBody(sf::FloatRect(), 0);
+	}
+
+	// Load the arena's colliders. They are added one after the other, so they can be tested in one go.
+	arenaBody = world.getBodyCount();
+	if (!world.loadStaticBodies("levels/arena.txt") || world.getBodyCount() == arenaBody)
+	{
+		std::cout << "Using the built-in arena instead of levels/arena.txt.\n";
+		addDefaultArena();
+	}
+	arenaBodyCount = world.getBodyCount() - arenaBody;
+	arenaHits.resize((arenaBodyCount + 31) / 32);
+
 	// Setup ball collision box outline.
 	ballBox.setOutlineThickness(2);
 	ballBox.setOutlineColor(sf::Color::Red);
 	ballBox.setFillColor(sf::Color::Transparent);
 	ballBox.setSize(ball.getSize());
 	ballBox.setPosition(ball.getCollisionBox().left, ball.getCollisionBox().top);
-	
-	// Setup players.
-	// ----
-	leftPlayer.setTexture(&messi);
-	leftPlayer.setSize(sf::Vector2f(100, 100));
-	leftPlayer.setCollisionBox(0, 0, leftPlayer.getSize().x, leftPlayer.getSize().y);
-
-	rightPlayer.setTexture(&ronaldo);
-	rightPlayer.setSize(sf::Vector2f(100, 100));
-	rightPlayer.setCollisionBox(0, 0, leftPlayer.getSize().x, leftPlayer.getSize().y);
-
-	leftPlayer.setFacingRight(true);
-	rightPlayer.setFacingRight(false);
-	// ----
 
 	// Setup goals.
 	// ----
-	goalSprite.loadFromFile("gfx/goalposts.png");
-	leftGoal.setTexture(&goalSprite);
 	leftGoal.setSize(sf::Vector2f(160, 200));
 	leftGoal.setCollisionBox(0, 0, leftGoal.getSize().x, leftGoal.getSize().y);
 
-	rightGoal.setTexture(&goalSprite);
 	rightGoal.setSize(sf::Vector2f(160, 200));
 	rightGoal.setCollisionBox(0, 0, rightGoal.getSize().x, rightGoal.getSize().y);
 	// ----
@@ -70,15 +92,15 @@ ObjectManager::ObjectManager()
 	// Setup text objects.
 	// ----
 	sf::Text infoText;
-	infoText.setFont(font);
+	infoText.setFont(*font);
 	infoText.setCharacterSize(20);
 	infoText.setFillColor(sf::Color::White);
 	infoText.setOutlineColor(sf::Color::Black);
 	infoText.setOutlineThickness(1);
 
-	ping = infoText;
-	score = infoText;
-	time = infoText;
+	ping.setStyle(infoText);
+	score.setStyle(infoText);
+	time.setStyle(infoText);
 
 	infoText.setCharacterSize(40);
 	infoText.setOutlineThickness(4);
@@ -88,8 +110,8 @@ ObjectManager::ObjectManager()
 	goal.setString("GOAL!");
 	// ----
 
-	// Seed random nmuber generator with time.
-	srand(std::time(NULL));
+	// Seed the kick generators until a match is started with the agreed seed.
+	seedKicks(0);
 }
 
 ObjectManager::~ObjectManager()
@@ -107,22 +129,51 @@ void ObjectManager::init(sf::RenderWindow* hwnd, Input* in, NetworkManager* nm,
 	audio = a;
 
 	// Set inputs.
-	leftPlayer.setInput(input);
-	rightPlayer.setInput(input);
+	for (int i = 0; i < players.size(); i++)
+	{
+		players[i].setInput(input);
+	}
+
+	// Arena fills the window.
+	setupArena(window->getSize());
+}
+
+void ObjectManager::initHeadless(sf::Vector2u size)
+{
+	// No window, input, networking or audio. Used by the benchmark to run the physics on its own.
+	window = nullptr;
+	input = nullptr;
+	networkManager = nullptr;
+	gameState = nullptr;
+	lobby = nullptr;
+	audio = nullptr;
+
+	// Everything is needed straight away, so wait for the atlas to load.
+	AssetLoader::getShared().finish();
+
+	setupArena(size);
+	controlledPlayer = &players[0];
+	ownsLeftTeam = true;
+	ownsAllPlayers = true;
+}
+
+void ObjectManager::setupArena(sf::Vector2u size)
+{
+	arenaSize = size;
 
 	// Setup objects.
 	// ----
-	floor.setSize(sf::Vector2f(window->getSize().x, 100));
+	floor.setSize(sf::Vector2f(arenaSize.x, 100));
 	floor.setFillColor(sf::Color::Green);
-	floor.setPosition(0, window->getSize().y - floor.getSize().y);
+	floor.setPosition(0, arenaSize.y - floor.getSize().y);
 	floor.setCollisionBox(0, 0, floor.getSize().x, floor.getSize().y);
 
-	ceiling.setSize(sf::Vector2f(window->getSize().x, 10));
+	ceiling.setSize(sf::Vector2f(arenaSize.x, 10));
 	ceiling.setFillColor(sf::Color::Black);
 	ceiling.setPosition(0, 0);
 	ceiling.setCollisionBox(0, 0, ceiling.getSize().x, ceiling.getSize().y);
 
-	leftWall.setSize(sf::Vector2f(10, window->getSize().y));
+	leftWall.setSize(sf::Vector2f(10, arenaSize.y));
 	leftWall.setFillColor(sf::Color::Black);
 	leftWall.setPosition(0, 0);
 	leftWall.setCollisionBox(0, 0, leftWall.getSize().x, leftWall.getSize().y);
@@ -130,20 +181,48 @@ void ObjectManager::init(sf::RenderWindow* hwnd, Input* in, NetworkManager* nm,
 	leftGoal.setPosition(leftWall.getSize().x, floor.getPosition().y - leftGoal.getSize().y);
 	leftGoal.setCollisionBox(0, 0, leftGoal.getSize().x, leftGoal.getSize().y * 0.02);
 
-	rightWall.setSize(sf::Vector2f(10, window->getSize().y));
+	rightWall.setSize(sf::Vector2f(10, arenaSize.y));
 	rightWall.setFillColor(sf::Color::Black);
-	rightWall.setPosition(window->getSize().x - rightWall.getSize().x, 0);
+	rightWall.setPosition(arenaSize.x - rightWall.getSize().x, 0);
 	rightWall.setCollisionBox(0, 0, rightWall.getSize().x, rightWall.getSize().y);
 
 	rightGoal.setPosition(rightWall.getPosition().x - rightGoal.getSize().x, floor.getPosition().y - rightGoal.getSize().y);
 	rightGoal.setCollisionBox(0, 0, rightGoal.getSize().x, rightGoal.getSize().y * 0.02);
 
-	// Flip texture
-	sf::IntRect textureRect = rightGoal.getTextureRect();
-	rightGoal.setTextureRect(sf::IntRect(textureRect.left + textureRect.width, textureRect.top, -textureRect.width, textureRect.height));
+	// Players start on their own side, facing the other team.
+	for (int i = 0; i < players.size(); i++)
+	{
+		players[i].setPosition(getStartPosition(i));
+		players[i].setFacingRight(i < teamSize);
+	}
+
+	ball.setPositionXY(arenaSize.x * 0.5 - 0.5 * ball.getSize().x, arenaSize.y * 0.2);
+	ball.setLagPosition(arenaSize.x * 0.5 - 0.5 * ball.getSize().x, arenaSize.y * 0.2);
+	// ----
+}
+
+void ObjectManager::addDefaultArena()
+{
+	// Floor, ceiling and walls, each solid on the side facing the pitch.
+	// ----
+	unsigned char solid = PhysicsWorld::STATIC;
+	int body = world.addBody(sf::FloatRect(0, 575, 1200, 100), solid | PhysicsWorld::SOLID_TOP);
+	world.setRestitution(body, 0.75f, 1, 0.9f, 0.9f);
+	body = world.addBody(sf::FloatRect(0, 0, 1200, 10), solid | PhysicsWorld::SOLID_BOTTOM);
+	world.setRestitution(body, 0.75f, 1, 0.9f, 0.9f);
+	body = world.addBody(sf::FloatRect(0, 0, 10, 675), solid | PhysicsWorld::SOLID_RIGHT);
+	world.setRestitution(body, 0.75f, 1, 0.9f, 0.9f);
+	body = world.addBody(sf::FloatRect(1190, 0, 10, 675), solid | PhysicsWorld::SOLID_LEFT);
+	world.setRestitution(body, 0.75f, 1, 0.9f, 0.9f);
+	// ----
 
-	ball.setPositionXY(window->getSize().x * 0.5 - 0.5 * ball.getSize().x, window->getSize().y * 0.2);
-	ball.setLagPosition(window->getSize().x * 0.5 - 0.5 * ball.getSize().x, window->getSize().y * 0.2);
+	// Crossbars along the top of each goal, solid on top, underneath and on the side facing the pitch.
+	// ----
+	unsigned char crossbar = solid | PhysicsWorld::SOLID_TOP | PhysicsWorld::SOLID_BOTTOM | PhysicsWorld::POST;
+	body = world.addBody(sf::FloatRect(10, 375, 160, 4), crossbar | PhysicsWorld::SOLID_RIGHT);
+	world.setRestitution(body, 0.75f, 1, 0.9f, 0.9f);
+	body = world.addBody(sf::FloatRect(1030, 375, 160, 4), crossbar | PhysicsWorld::SOLID_LEFT);
+	world.setRestitution(body, 0.75f, 1, 0.9f, 0.9f);
 	// ----
 }
 
@@ -153,6 +232,24 @@ void ObjectManager::handleInput(float dt)
 	controlledPlayer->handleInput(dt);
 }
 
+void ObjectManager::updateTeammates()
+{
+	// Each teammate follows the ball from further back than the last, so the team spreads out between the ball and its own goal.
+	float back = 0;
+	for (int i = 0; i < getPlayerCount(); i++)
+	{
+		if (!isOwnPlayer(i) || &players[i] == controlledPlayer)
+		{
+			continue;
+		}
+
+		back += 150;
+		sf::Vector2f target = ball.getPositionXY();
+		target.x += i < teamSize ? -back : back;
+		players[i].chase(target, ball.getPositionXY());
+	}
+}
+
 void ObjectManager::update(float dt)
 {
 	// Increase timers.
@@ -168,44 +265,30 @@ void ObjectManager::update(float dt)
 	}
 
 	// If player is kicking, set their colour to red. Otherwise set their colour to white (normal).
-	// ----
-	if (leftPlayer.getKicking())
+	for (int i = 0; i < getPlayerCount(); i++)
 	{
-		leftPlayer.setFillColor(sf::Color::Red);
-	}
-	else
-	{
-		leftPlayer.setFillColor(sf::Color::White);
-	}
-	
-	if (rightPlayer.getKicking())
-	{
-		rightPlayer.setFillColor(sf::Color::Red);
+		if (players[i].getKicking())
+		{
+			players[i].setFillColor(sf::Color::Red);
+		}
+		else
+		{
+			players[i].setFillColor(sf::Color::White);
+		}
 	}
-	else
+
+	// Run a physics step for each step's worth of time that has passed, so physics runs at the same rate whatever the frame rate is.
+	// After a long stall only a few steps are run and the whole steps still due are dropped, so catching up can't make the next frame slower still. The part of a step left over is kept either way.
+	int steps = 0;
+	while (physicsTimer > physicsStep && steps < maxPhysicsSteps)
 	{
-		rightPlayer.setFillColor(sf::Color::White);
+		physicsTimer -= physicsStep;
+		stepPhysics();
+		steps++;
 	}
-	// ----
-
-	// Run physics when timer exceeds the physics step rate.
 	if (physicsTimer > physicsStep)
 	{
-		physicsTimer -= physicsStep;
-
-		// Check ball and player collisions with the environment (not each other).
-		checkBallCollision();
-		checkPlayerCollision(controlledPlayer);
-
-		// Ball physics and prediction.
-		networkManager->runPrediction(physicsStep);
-		ball.update(physicsStep);
-
-		// Check for collision between ball and player.
-		checkPlayerBallCollision();
-
-		// Update player.
-		controlledPlayer->update(physicsStep);
+		physicsTimer = std::fmod(physicsTimer, physicsStep);
 	}
 
 	// When a goal hasn't been scored yet, check if a goal has been scored.
@@ -249,20 +332,28 @@ void ObjectManager::update(float dt)
 		}
 	}
 	
-	// Setup text objects
+	// Setup text objects. Values are formatted into a buffer rather than a std::string, so nothing is allocated unless the text changes.
 	// ----
+	char buffer[HudText::maxLength + 1];
+
 	ping.setPosition(window->getSize().x * 0.1, window->getSize().y * 0.1);
-	ping.setString("Ping: " + std::to_string(networkManager->getPing()));
+	if (networkManager->getReconnecting())
+	{
+		ping.setString("Reconnecting...");
+	}
+	else
+	{
+		std::snprintf(buffer, sizeof(buffer), "Ping: %d", networkManager->getPing());
+		ping.setString(buffer);
+	}
 	
+	std::snprintf(buffer, sizeof(buffer), "%d - %d", leftScore, rightScore);
+	score.setString(buffer);
 	score.setPosition(window->getSize().x * 0.5 - score.getGlobalBounds().width * 0.5, window->getSize().y * 0.1);
-	score.setString(std::to_string(leftScore) + " - " + std::to_string(rightScore));
 
 	time.setPosition(window->getSize().x * 0.8, window->getSize().y * 0.1);
-
-	std::stringstream stream;
-	stream << "Time: " << std::fixed << std::setprecision(2) << gameTimer;
-	std::string timeString = stream.str();
-	time.setString(timeString);
+	std::snprintf(buffer, sizeof(buffer), "Time: %.2f", gameTimer);
+	time.setString(buffer);
 
 	goal.setPosition(window->getSize().x * 0.5 - goal.getGlobalBounds().width * 0.5, window->getSize().y * 0.3);
 	// ----
@@ -271,288 +362,260 @@ void ObjectManager::update(float dt)
 	ballBox.setPosition(ball.getCollisionBox().left, ball.getCollisionBox().top);
 }
 
-void ObjectManager::render()
+void ObjectManager::stepPhysics()
 {
-	// Render objects in world
-	//window->draw(ballBox); // ball collision box
-	window->draw(ball);
-	window->draw(floor);
-	window->draw(ceiling);
-	window->draw(leftWall);
-	window->draw(rightWall);
-
-	// Change render order of players based on whether you're host so that your player is on top.
-	if (networkManager->getHost())
-	{
-		window->draw(rightPlayer);
-		window->draw(leftPlayer);
-	}
-	else
+	// Presses read before this step are first shown by frames recorded after it.
+	LatencyProbe::getShared().stepStarted();
+
+	// Teammates decide where to go.
+	updateTeammates();
+
+	// Check ball and player collisions with the environment (not each other).
+	checkBallCollision();
+	for (int i = 0; i < getPlayerCount(); i++)
 	{
-		window->draw(leftPlayer);
-		window->draw(rightPlayer);
+		if (isOwnPlayer(i))
+		{
+			checkPlayerCollision(&players[i]);
+		}
 	}
-	
-	// Render rest of objects
-	window->draw(leftGoal);
-	window->draw(rightGoal);
-	window->draw(ping);
-	window->draw(score);
-	window->draw(time);
 
-	// If a goal has been scored, display goal text.
-	if (goalScored)
+	// Ball physics and prediction.
+	if (networkManager)
 	{
-		window->draw(goal);
+		networkManager->runPrediction(physicsStep);
 	}
-}
+	ball.update(physicsStep);
+	playBallContactSounds();
 
+	// Check for collision between ball and players.
+	checkPlayerBallCollision();
 
- 
-void ObjectManager::checkPlayerCollision(Player* player)
-{
-	// Check player - floor collision, then set player position, velocity and jump state.
-	if (Collision::checkBoundingBox(player, &floor))
+	// Update players.
+	for (int i = 0; i < getPlayerCount(); i++)
 	{
-		if (player->getVelocity().y > 0)
+		if (isOwnPlayer(i))
 		{
-			player->setPosition(player->getPosition().x, floor.getPosition().y - floor.getCollisionBox().height);
-			player->setVelocity(player->getVelocity().x, 0);
-			player->setJumping(false);
+			players[i].update(physicsStep);
 		}
 	}
+}
 
-	// Check player - ceiling collision, then set player velocity.
-	if (Collision::checkBoundingBox(player, &ceiling))
+void ObjectManager::render(RenderSnapshot& snapshot)
+{
+	// Render objects in world. The sprites share the atlas texture, so consecutive ones batch into one draw call.
+	//snapshot.draw(ballBox); // ball collision box
+	drawSprite(snapshot, ball);
+	drawSprite(snapshot, floor);
+	drawSprite(snapshot, ceiling);
+	drawSprite(snapshot, leftWall);
+	drawSprite(snapshot, rightWall);
+
+	// Draw the other team, then your own team, then your player, so that your player is on top.
+	for (int i = 0; i < getPlayerCount(); i++)
 	{
-		if (player->getVelocity().y < 0)
+		if (!isOwnPlayer(i))
 		{
-			player->setVelocity(player->getVelocity().x, 0);
+			drawSprite(snapshot, players[i]);
 		}
 	}
 
-	// Check player - wall collision, then set player velocity.
-	if (Collision::checkBoundingBox(player, &leftWall))
+	for (int i = 0; i < getPlayerCount(); i++)
 	{
-		if (player->getVelocity().x < 0)
+		if (isOwnPlayer(i) && &players[i] != controlledPlayer)
 		{
-			player->setVelocity(0, player->getVelocity().y);
+			drawSprite(snapshot, players[i]);
 		}
 	}
+	drawSprite(snapshot, *controlledPlayer);
+	
+	// Render rest of objects
+	drawSprite(snapshot, leftGoal);
+	drawSprite(snapshot, rightGoal);
 
-	// Check player - wall collision, then set player velocity.
-	if (Collision::checkBoundingBox(player, &rightWall))
+	// Text is drawn on top of everything, one draw call each.
+	snapshot.draw(ping);
+	snapshot.draw(score);
+	snapshot.draw(time);
+
+	// If a goal has been scored, display goal text.
+	if (goalScored)
 	{
-		if (player->getVelocity().x > 0)
-		{
-			player->setVelocity(0, player->getVelocity().y);
-		}
+		snapshot.draw(goal);
 	}
+}
 
-	// Check player - goal collision. Additional checks so that player only collides with top of goal. Appropriate variables set according to where collision occured.
-	if (Collision::checkBoundingBox(player, &leftGoal))
+void ObjectManager::drawSprite(RenderSnapshot& snapshot, GameObject& object)
+{
+	if (batchSprites)
 	{
-		if (player->getCollisionBox().left < leftGoal.getCollisionBox().left + leftGoal.getCollisionBox().width)
-		{
-			if (player->getVelocity().x < 0 && player->getPosition().x > 150)
-			{
-				player->setVelocity(0, player->getVelocity().y);
-				player->setPosition(leftGoal.getCollisionBox().left + leftGoal.getCollisionBox().width + 1, player->getPosition().y);
-			}
-				
-			
-			if (player->getPosition().x < leftGoal.getCollisionBox().left + leftGoal.getCollisionBox().width)
-			{
-				if (player->getVelocity().y > 0)
-				{
-					player->setPosition(player->getPosition().x, leftGoal.getPosition().y - player->getSize().y);
-					player->setVelocity(player->getVelocity().x, 0);
-					player->setJumping(false);
-				}
-				else if (player->getVelocity().y < 0)
-				{
-					player->setPosition(player->getPosition().x, leftGoal.getPosition().y + leftGoal.getCollisionBox().height);
-					player->setVelocity(player->getVelocity().x, 0);
-				}
-			}
-		}		
+		snapshot.batch(object);
 	}
-
-	// Check player - goal collision. Additional checks so that player only collides with top of goal. Appropriate variables set according to where collision occured.
-	if (Collision::checkBoundingBox(player, &rightGoal))
+	else
 	{
-		if (player->getCollisionBox().left + player->getCollisionBox().width > rightGoal.getCollisionBox().left)
-		{
-			if (player->getVelocity().x > 0 && player->getPosition().x < 1050 - player->getCollisionBox().width)
-			{
-				player->setVelocity(0, player->getVelocity().y);
-				player->setPosition(rightGoal.getCollisionBox().left - player->getCollisionBox().width, player->getPosition().y);
-			}
-
-			
-			if (player->getPosition().x > rightGoal.getCollisionBox().left - player->getCollisionBox().width)
-			{
-				if (player->getVelocity().y > 0)
-				{
-					player->setPosition(player->getPosition().x, rightGoal.getPosition().y - player->getSize().y);
-					player->setVelocity(player->getVelocity().x, 0);
-					player->setJumping(false);
-				}
-				else if (player->getVelocity().y < 0)
-				{
-					player->setPosition(player->getPosition().x, rightGoal.getPosition().y + rightGoal.getCollisionBox().height);
-					player->setVelocity(player->getVelocity().x, 0);
-				}
-			}
-		}
+		snapshot.draw(object);
 	}
 }
 
-void ObjectManager::checkBallCollision()
+void ObjectManager::checkPlayerCollision(Player* player)
 {
-	// Check ball - floor collision, then adjust velocity for ball to bounce.
-	if (Collision::checkBoundingBox(&ball, &floor))
+	// Copy the player into the physics world, keeping track of where its collision box sits relative to its position.
+	int playerBody = firstPlayerBody + int(player - &players[0]);
+	sf::FloatRect box = player->getCollisionBox();
+	sf::Vector2f boxOffset = sf::Vector2f(box.left, box.top) - player->getPosition();
+	world.setBox(playerBody, box);
+	world.setVelocity(playerBody, player->getVelocity());
+
+	// Resolve against each of the arena's colliders in turn, as each one can move the player. Players stop against surfaces rather than bouncing, and landing on top of something lets them jump again.
+	for (int i = 0; i < arenaBodyCount; i++)
 	{
-		//ball.setPositionXY(ball.getPosition().x, floor.getCollisionBox().top - ball.getSize().x / 2 - 5);
-		if (ball.getVelocity().y > 0)
+		if (world.resolve(playerBody, arenaBody + i, false) == PhysicsWorld::TOP)
 		{
-			ball.setVelocity(ball.getVelocity().x, -ball.getVelocity().y * 0.75);
+			player->setJumping(false);
 		}
 	}
 
-	// Check ball - ceiling collision, then adjust velocity for ball to bounce.
-	if (Collision::checkBoundingBox(&ball, &ceiling))
+	// Copy the result back to the player.
+	box = world.getBox(playerBody);
+	player->setPosition(sf::Vector2f(box.left, box.top) - boxOffset);
+	player->setVelocity(world.getVelocity(playerBody));
+}
+
+void ObjectManager::checkBallCollision()
+{
+	// Test the ball against the whole arena in one go. The ball doesn't move while bouncing, so the result holds for every collider.
+	world.overlapMask(ballBody, arenaBody, arenaBodyCount, arenaHits.data());
+
+	for (int i = 0; i < arenaBodyCount; i++)
 	{
-		if (ball.getVelocity().y < 0)
+		if (!(arenaHits[i / 32] & 1u << (i % 32)))
 		{
-			ball.setVelocity(ball.getVelocity().x, -ball.getVelocity().y);
+			continue;
 		}
-	}
 
-	// Check ball - wall collision, then adjust velocity for ball to bounce.
-	if (Collision::checkBoundingBox(&ball, &leftWall))
-	{
-		if (ball.getVelocity().x < 0)
+		// Bounce off whichever face the ball has hit. Hitting the side of a post plays a sound.
+		PhysicsWorld::Face face = world.resolve(ballBody, arenaBody + i, true);
+		if ((face == PhysicsWorld::LEFT || face == PhysicsWorld::RIGHT) && world.getFlag(arenaBody + i, PhysicsWorld::POST) && audio)
 		{
-			ball.setVelocity(-ball.getVelocity().x * 0.9, ball.getVelocity().y);
+			audio->playSoundbyName("post");
 		}
 	}
+}
 
-	// Check ball - wall collision, then adjust velocity for ball to bounce.
-	if (Collision::checkBoundingBox(&ball, &rightWall))
+void ObjectManager::playBallContactSounds()
+{
+	// The ball bounces off the arena while it moves, so check what it hit during the step. Hitting the side of a post plays a sound.
+	for (int i = 0; i < world.getContactCount(); i++)
 	{
-		if (ball.getVelocity().x > 0)
+		PhysicsWorld::Face face = world.getContactFace(i);
+		if ((face == PhysicsWorld::LEFT || face == PhysicsWorld::RIGHT) && world.getFlag(world.getContactBody(i), PhysicsWorld::POST) && audio)
 		{
-			ball.setVelocity(-ball.getVelocity().x * 0.9, ball.getVelocity().y);
+			audio->playSoundbyName("post");
 		}
 	}
+}
 
-	// Check ball - goal collision. Additional checks so that ball only collides with top of goal. Bounce determined by where the collision occurs. If the front of the crossbar is hit, play a sound.
-	if (Collision::checkBoundingBox(&ball, &leftGoal))
+void ObjectManager::checkPlayerBallCollision()
+{
+	// Copy every player into the physics world, then find which of them touch the ball using the grid. The ball and players' bodies are one after the other.
+	for (int i = 0; i < getPlayerCount(); i++)
 	{
-		if (ball.getCollisionBox().left < leftGoal.getCollisionBox().left + leftGoal.getCollisionBox().width)
-		{
-			if (ball.getVelocity().x < 0 && ball.getPosition().x > 150)
-			{
-				ball.setVelocity(-ball.getVelocity().x * 0.9, ball.getVelocity().y);
-				audio->playSoundbyName("post");
-			}
-
-			if (ball.getPosition().x < leftGoal.getCollisionBox().left + leftGoal.getCollisionBox().width)
-			{
-				if (ball.getVelocity().y > 0)
-				{
-					ball.setVelocity(ball.getVelocity().x, -ball.getVelocity().y * 0.75);
-				}
-				else if (ball.getVelocity().y < 0)
-				{
-					ball.setVelocity(ball.getVelocity().x, -ball.getVelocity().y);
-				}
-			}
-		}
+		world.setBox(firstPlayerBody + i, players[i].getCollisionBox());
 	}
 
-	// Check ball - goal collision. Additional checks so that ball only collides with top of goal. Bounce determined by where the collision occurs. If the front of the crossbar is hit, play a sound.
-	if (Collision::checkBoundingBox(&ball, &rightGoal))
+	pairs.clear();
+	grid.build(world, ballBody, getPlayerCount() + 1);
+	grid.findPairs(world, pairs);
+
+	// The ball's body comes first, so it is the first of any pair it is in. Only this client's players hit the ball, and only one per step.
+	for (int i = 0; i < pairs.size(); i++)
 	{
-		if (ball.getCollisionBox().left + ball.getCollisionBox().width > rightGoal.getCollisionBox().left)
+		int player = pairs[i].second - firstPlayerBody;
+		if (pairs[i].first == ballBody && isOwnPlayer(player))
 		{
-			if (ball.getVelocity().x > 0 && ball.getPosition().x < 1050)
-			{
-				ball.setVelocity(-ball.getVelocity().x * 0.9, ball.getVelocity().y);
-				audio->playSoundbyName("post");
-			}
-
-
-			if (ball.getPosition().x > rightGoal.getCollisionBox().left - ball.getCollisionBox().width)
-			{
-				if (ball.getVelocity().y > 0)
-				{
-					ball.setVelocity(ball.getVelocity().x, -ball.getVelocity().y * 0.75);
-				}
-				else if (ball.getVelocity().y < 0)
-				{
-					ball.setVelocity(ball.getVelocity().x, -ball.getVelocity().y);
-				}
-			}
+			kickBall(&players[player]);
+			return;
 		}
 	}
 }
 
-void ObjectManager::checkPlayerBallCollision()
+void ObjectManager::kickBall(Player* player)
 {
-	// When the player collides with the ball...
-	if (Collision::checkBoundingBox(controlledPlayer, &ball))
+	// Calculate direction vector between centre of both objects
+	sf::Vector2f directionVector = calculateDirection(player->getCentre(), ball.getCentre());
+
+	// Randomise height of shot, using the kicking player's team's generator.
+	int team = int(player - &players[0]) < teamSize ? 0 : 1;
+	float yPower = float(kickRandom[team].range(2000, 2750));
+
+	// Calculate velocity of ball based on direction, the player's speed, and whether they're kicking or not. Worked out in the physics' number type, the same as the ball's motion.
+	using std::abs;
+	RealVector direction(directionVector.x, directionVector.y);
+	RealVector playerVelocity(player->getVelocity().x, player->getVelocity().y);
+	RealVector velocity;
+	Real half = Real(0.5f);
+	if (player->getKicking())
 	{
-		// Calculate direction vector between centre of both objects
-		sf::Vector2f directionVector = calculateDirection(controlledPlayer->getCentre(), ball.getCentre());
-
-		// Randomise height of shot.
-		float yPower = rand() % 750 + 2000; 
-
-		// Calculate velocity of ball based on direction, the player's speed, and whether they're kicking or not.
-		if (controlledPlayer->getKicking())
+		velocity = RealVector(playerVelocity.x * half + direction.x * 1500, playerVelocity.y * half - abs(direction.y) * Real(yPower));
+	}
+	else
+	{
+		if (player->getCollisionBox().top + player->getCollisionBox().height - 5 < ball.getPosition().y - ball.getSize().y/2) // Don't use absolute y direction if player is hitting from above.
 		{
-			ball.setVelocity(controlledPlayer->getVelocity().x * 0.5 + directionVector.x * 1500, controlledPlayer->getVelocity().y * 0.5 + -abs(directionVector.y) * yPower);
+			velocity = RealVector(playerVelocity.x * half + direction.x * 500, playerVelocity.y * half + direction.y * 500);
 		}
 		else
 		{
-			if (controlledPlayer->getCollisionBox().top + controlledPlayer->getCollisionBox().height - 5 < ball.getPosition().y - ball.getSize().y/2) // Don't use absolute y direction if player is hitting from above.
-			{
-				ball.setVelocity(controlledPlayer->getVelocity().x * 0.5 + directionVector.x * 500, controlledPlayer->getVelocity().y * 0.5 + directionVector.y * 500);
-			}
-			else
-			{
-				ball.setVelocity(controlledPlayer->getVelocity().x * 0.5 + directionVector.x * 500, controlledPlayer->getVelocity().y * 0.5 + -abs(directionVector.y) * 500);
-			}
-			
+			velocity = RealVector(playerVelocity.x * half + direction.x * 500, playerVelocity.y * half - abs(direction.y) * 500);
 		}
+		
+	}
+	ball.setVelocity(float(velocity.x), float(velocity.y));
 
-		// Send collision to the other player.
+	// Send collision to the other player and play kicking sound effect. Neither exist when running headlessly.
+	if (networkManager)
+	{
 		networkManager->setBallCollision(ball.getPosition(), ball.getVelocity());
+	}
 
-		// Play kicking sound effect.
+	if (audio)
+	{
 		audio->playSoundbyName("kick");
 	}
 }
 
+// Check a player against a body in the physics world. The player is copied into the world first, as players still move themselves.
+bool ObjectManager::checkCollision(Player* player, int body)
+{
+	int playerBody = firstPlayerBody + int(player - &players[0]);
+	world.setBox(playerBody, player->getCollisionBox());
+	return world.overlaps(playerBody, body);
+}
+
 void ObjectManager::setupPlayers()
 {
-	// If client is host...
-	if (networkManager->getHost()) // Control the left player.
-	{
-		controlledPlayer = &leftPlayer;
-		networkManager->setControlledPlayer(controlledPlayer);
-		networkManager->setOtherPlayer(&rightPlayer);
-		controlledPlayer->setPosition(window->getSize().x * 0.25 - 0.5 * leftPlayer.getSize().x, 400);
-	}
-	else if (networkManager->getHost() == false) // Otherwise control the right player.
+	// The host controls the first player of the left team, and the client the first player of the right team. Each client simulates its own team.
+	ownsLeftTeam = networkManager->getHost();
+	controlledPlayer = &players[ownsLeftTeam ? 0 : teamSize];
+}
+
+void ObjectManager::setTeamSize(int size)
+{
+	teamSize = std::min(std::max(size, 1), int(maxTeamSize));
+}
+
+sf::Vector2f ObjectManager::getStartPosition(int player)
+{
+	// The first player of each team starts in the same place as in a 1v1 match. Teammates alternate behind and in front of them.
+	bool left = player < teamSize;
+	int place = left ? player : player - teamSize;
+	float offset = float((place + 1) / 2 * 110) * (place % 2 == 1 ? -1 : 1);
+
+	if (left)
 	{
-		controlledPlayer = &rightPlayer;
-		networkManager->setControlledPlayer(controlledPlayer);
-		networkManager->setOtherPlayer(&leftPlayer);
-		controlledPlayer->setPosition(window->getSize().x * 0.65 + 0.5 * rightPlayer.getSize().x, 400);
+		return sf::Vector2f(arenaSize.x * 0.25 - 0.5 * players[player].getSize().x + offset, 400);
 	}
+	return sf::Vector2f(arenaSize.x * 0.65 + 0.5 * players[player].getSize().x - offset, 400);
 }
 
 void ObjectManager::goalReset()
@@ -560,20 +623,17 @@ void ObjectManager::goalReset()
 	// Reset ball's positions.
 	resetBallPosition();
 	
-	// Move player back to start position (only move own player, will receive position update from the other player).
-	if (controlledPlayer == &leftPlayer)
+	// Move this client's players back to their start positions (the other team's positions will be received from the other player), and reset directions.
+	for (int i = 0; i < getPlayerCount(); i++)
 	{
-		controlledPlayer->setPosition(window->getSize().x * 0.25 - 0.5 * leftPlayer.getSize().x, 400);
-	}
-	else if (controlledPlayer == &rightPlayer)
-	{
-		controlledPlayer->setPosition(window->getSize().x * 0.65 + 0.5 * leftPlayer.getSize().x, 400);
+		if (isOwnPlayer(i))
+		{
+			players[i].setPosition(getStartPosition(i));
+			players[i].setVelocity(0, 0);
+		}
+		players[i].setFacingRight(i < teamSize);
 	}
 
-	// Reset directions.
-	leftPlayer.setFacingRight(true);
-	rightPlayer.setFacingRight(false);
-
 	// Reset timer and goal scored bool.
 	resetTimer = 0;
 	goalScored = false;
@@ -583,53 +643,32 @@ void ObjectManager::resetBallPosition()
 {
 	// Reset ball's velocity and position.
 	ball.setVelocity(0, 0);
-	ball.setPositionXY(window->getSize().x * 0.5 - 0.5 * ball.getSize().x, window->getSize().y * 0.2);
-	ball.setLagPosition(window->getSize().x * 0.5 - 0.5 * ball.getSize().x, window->getSize().y * 0.2);
+	ball.setPositionXY(arenaSize.x * 0.5 - 0.5 * ball.getSize().x, arenaSize.y * 0.2);
+	ball.setLagPosition(arenaSize.x * 0.5 - 0.5 * ball.getSize().x, arenaSize.y * 0.2);
 }
 
 void ObjectManager::start()
 {
+	// The match needs every asset, so wait for any still loading. They have normally finished long before a match starts.
+	AssetLoader::getShared().finish();
+
+	// Use the team size the host chose, and work out which player is controlled.
+	setTeamSize(networkManager->getTeamSize());
+	setupPlayers();
+	seedKicks(networkManager->getMatchSeed());
+
 	// Reset scores, network manager data and player/ball positions.
 	leftScore = 0;
 	rightScore = 0;
 	networkManager->resetPositionData();
 	goalReset();
 
-	// Set each player's texture based on their selected character
-	// ----
-	switch (lobby->getHostChar())
+	// Set each team's texture based on their selected character.
+	for (int i = 0; i < getPlayerCount(); i++)
 	{
-	case Lobby::Character::MESSI:
-		leftPlayer.setTexture(&messi);
-		break;
-	case Lobby::Character::RONALDO:
-		leftPlayer.setTexture(&ronaldo);
-		break;
-	case Lobby::Character::KIRBY:
-		leftPlayer.setTexture(&kirby);
-		break;
-	case Lobby::Character::MIEDEMA:
-		leftPlayer.setTexture(&miedema);
-		break;
+		players[i].setSprite(atlas.getTexture(), getCharacterRegion(i < teamSize ? lobby->getHostChar() : lobby->getClientChar()));
 	}
 
-	switch (lobby->getClientChar())
-	{
-	case Lobby::Character::MESSI:
-		rightPlayer.setTexture(&messi);
-		break;
-	case Lobby::Character::RONALDO:
-		rightPlayer.setTexture(&ronaldo);
-		break;
-	case Lobby::Character::KIRBY:
-		rightPlayer.setTexture(&kirby);
-		break;
-	case Lobby::Character::MIEDEMA:
-		rightPlayer.setTexture(&miedema);
-		break;
-	}
-	// ----
-
 	// If player is host, sync time to other player.
 	if (networkManager->getHost())
 	{
@@ -638,18 +677,74 @@ void ObjectManager::start()
 	}
 }
 
+void ObjectManager::seedKicks(sf::Uint64 seed)
+{
+	// Same seed, different stream for each team.
+	kickRandom[0].seed(seed, 0);
+	kickRandom[1].seed(seed, 1);
+}
+
+void ObjectManager::otherTeamKicked(sf::Uint64 kickState)
+{
+	kickRandom[ownsLeftTeam ? 1 : 0].setState(kickState);
+}
+
+void ObjectManager::setupSprites()
+{
+	// Every sprite uses the atlas texture, with its own region of it.
+	sf::Texture* atlasTexture = atlas.getTexture();
+	ball.setTexture(atlasTexture);
+	ball.setTextureRect(atlas.getRegion("football"));
+
+	for (int i = 0; i < players.size(); i++)
+	{
+		players[i].setSprite(atlasTexture, atlas.getRegion(i < maxTeamSize ? "messi" : "ronaldo"));
+	}
+
+	// The right goal's texture is flipped to face the pitch.
+	sf::IntRect goalRegion = atlas.getRegion("goalposts");
+	leftGoal.setTexture(atlasTexture);
+	leftGoal.setTextureRect(goalRegion);
+	rightGoal.setTexture(atlasTexture);
+	rightGoal.setTextureRect(sf::IntRect(goalRegion.left + goalRegion.width, goalRegion.top, -goalRegion.width, goalRegion.height));
+
+	// The floor, ceiling and walls are plain colours. Drawing them with the atlas's white region lets them batch with the sprites.
+	GameObject* plain[4] = { &floor, &ceiling, &leftWall, &rightWall };
+	for (int i = 0; i < 4; i++)
+	{
+		plain[i]->setTexture(atlasTexture);
+		plain[i]->setTextureRect(atlas.getRegion("white"));
+	}
+}
+
+sf::IntRect ObjectManager::getCharacterRegion(int character)
+{
+	switch (character)
+	{
+	case Lobby::Character::RONALDO:
+		return atlas.getRegion("ronaldo");
+	case Lobby::Character::KIRBY:
+		return atlas.getRegion("kirby");
+	case Lobby::Character::MIEDEMA:
+		return atlas.getRegion("miedema");
+	default:
+		return atlas.getRegion("messi");
+	}
+}
+
 sf::Vector2f ObjectManager::calculateDirection(sf::Vector2f pos1, sf::Vector2f pos2)
 {
-	sf::Vector2f output;
+	using std::sqrt;
+	RealVector output;
 
 	// Difference in positions.
-	output = pos2 - pos1;
+	output = RealVector(Real(pos2.x) - Real(pos1.x), Real(pos2.y) - Real(pos1.y));
 
-	// Magnitude of the vector.
-	float magnitude = sqrt(pow(output.x, 2) + pow(output.y, 2));
+	// Magnitude of the vector. Squared rather than using pow(), which maths libraries can round differently.
+	Real magnitude = sqrt(output.x * output.x + output.y * output.y);
 
 	// Convert to unit vector by dividing by magnitude.
 	output = output / magnitude;
 
-	return output;
+	return sf::Vector2f(float(output.x), float(output.y));
 }
@@ -4,14 +4,24 @@
 #include "Ball.h"
 #include "Framework/GameObject.h"
 #include "Framework/Collision.h"
+#include "PhysicsWorld.h"
+#include "SpatialGrid.h"
+#include "Random.h"
+#include "RenderSnapshot.h"
+#include "TextureAtlas.h"
+#include "ResourceCache.h"
+#include "AssetLoader.h"
+#include "HudText.h"
+#include "LatencyProbe.h"
 #include "NetworkManager.h"
 #include "Lobby.h"
 
 class NetworkManager;
 class Lobby;
 
-// Object manager class. This is where the gameplay is controlled. This class controls both players and the ball, and their interactions.
+// Object manager class. This is where the gameplay is controlled. This class controls the players and the ball, and their interactions.
 // Updates are sent to the network manager when certain events occur, such as collisions or goals being scored.
+// Matches can be 1v1 up to 5v5. Players are stored one after the other, left team first, with their physics bodies straight after the ball's. Each client controls one player of its own team, and the rest of its team follow the ball on their own.
 class ObjectManager
 {
 public:
@@ -21,19 +31,52 @@ public:
 	// Main functions.
 	void handleInput(float dt);
 	void update(float dt);
-	void render();
+
+	// Record everything to draw into a snapshot, which the render thread (or the benchmark, without a window) draws.
+	void render(RenderSnapshot& snapshot);
 
 	// Initialise pointers and variables that rely on the pointers.
 	void init(sf::RenderWindow* hwnd, Input* input, NetworkManager* nm, GameState* gs, Lobby* l, AudioManager* a);
 
+	// Initialise without a window, networking or audio, with the first left player controlled and every player simulated. Only the physics functions and rendering to a target can be used.
+	void initHeadless(sf::Vector2u size);
+
+	// Run one physics step: collisions, the ball, and this client's players.
+	void stepPhysics();
+
+	// Move this client's players that aren't controlled by the user towards the ball.
+	void updateTeammates();
+
 	// Functions for checking collisions.
 	void checkPlayerCollision(Player* player);
 	void checkBallCollision();
 	void checkPlayerBallCollision();
+	bool checkCollision(Player* player, int body);
+
+	// Change the ball's velocity after a player has hit it, and send the collision.
+	void kickBall(Player* player);
+
+	// Play sounds for anything the ball bounced off while it moved during the last physics step.
+	void playBallContactSounds();
 
-	// Function for setting up the player pointers.
+	// Record an object, either into the snapshot's sprite batch or to be drawn on its own.
+	void drawSprite(RenderSnapshot& snapshot, GameObject& object);
+
+	// Seed each team's kick generator for a match. Both clients use the seed agreed when they connected, so they draw the same kick powers.
+	void seedKicks(sf::Uint64 seed);
+
+	// The other team has kicked the ball. Set this client's copy of their kick generator to the state they sent, so it stays in step with theirs.
+	void otherTeamKicked(sf::Uint64 kickState);
+
+	// Function for setting up which player is controlled.
 	void setupPlayers();
 
+	// Set the number of players on each team, up to maxTeamSize. Takes effect for the next match.
+	void setTeamSize(int size);
+
+	// Where a player starts, spread out around their team's side.
+	sf::Vector2f getStartPosition(int player);
+
 	// Reset functions.
 	void goalReset();
 	void resetBallPosition();
@@ -48,6 +91,12 @@ public:
 		gameTimer = time;
 	}
 
+	// Turn sprite batching on or off. On unless turned off, such as to compare against drawing each object on its own.
+	void setBatchSprites(bool b)
+	{
+		batchSprites = b;
+	}
+
 	void setGoalScored(bool b)
 	{
 		goalScored = b;
@@ -57,6 +106,12 @@ public:
 	{
 		resetTimer = t;
 	}
+
+	void setScore(int left, int right)
+	{
+		leftScore = left;
+		rightScore = right;
+	}
 	// ----
 
 	// Getter functions
@@ -71,6 +126,12 @@ public:
 		return &ball;
 	}
 
+	// Kick generator for the left (0) or right (1) team.
+	Random* getKickRandom(int team)
+	{
+		return &kickRandom[team];
+	}
+
 	GameObject* getLeftWall()
 	{
 		return &leftWall;
@@ -91,10 +152,93 @@ public:
 		return &ceiling;
 	}
 
+	GameObject* getLeftGoal()
+	{
+		return &leftGoal;
+	}
+
+	GameObject* getRightGoal()
+	{
+		return &rightGoal;
+	}
+
+	// Physics world, the ball's body and the first of the arena's bodies, which are added one after the other.
+	PhysicsWorld* getWorld()
+	{
+		return &world;
+	}
+
+	int getBallBody()
+	{
+		return ballBody;
+	}
+
+	int getArenaBody()
+	{
+		return arenaBody;
+	}
+
+	int getArenaBodyCount()
+	{
+		return arenaBodyCount;
+	}
+
 	float getPhysicsStep()
 	{
 		return physicsStep;
 	}
+
+	Player* getControlledPlayer()
+	{
+		return controlledPlayer;
+	}
+
+	// Players in the match, left team first.
+	int getPlayerCount()
+	{
+		return teamSize * 2;
+	}
+
+	int getTeamSize()
+	{
+		return teamSize;
+	}
+
+	Player* getPlayer(int player)
+	{
+		return &players[player];
+	}
+
+	// Whether a player is simulated by this client (its own team) rather than received from the other client.
+	bool isOwnPlayer(int player)
+	{
+		return ownsAllPlayers || (player < teamSize) == ownsLeftTeam;
+	}
+
+	sf::Vector2u getArenaSize()
+	{
+		return arenaSize;
+	}
+
+	int getLeftScore()
+	{
+		return leftScore;
+	}
+
+	int getRightScore()
+	{
+		return rightScore;
+	}
+
+	bool getGoalScored()
+	{
+		return goalScored;
+	}
+
+	float getResetTimer()
+	{
+		return resetTimer;
+	}
 	// ----
 	
 	// Functions for increasing score
@@ -112,7 +256,22 @@ public:
 	
 	// Function to calculate direction between two points.
 	sf::Vector2f calculateDirection(sf::Vector2f pos1, sf::Vector2f pos2);
+
+	// Most players on each team.
+	static const int maxTeamSize = 5;
 private:
+	// Give the ball, players, goals and arena their regions of the atlas, once it has loaded.
+	void setupSprites();
+
+	// Region of the atlas for a character selected in the lobby.
+	sf::IntRect getCharacterRegion(int character);
+
+	// Position and size the walls, floor, ceiling and goals to fit the arena, and place the ball.
+	void setupArena(sf::Vector2u size);
+
+	// Add the arena's colliders without the level description, the same as levels/arena.txt. Used if the file can't be loaded, so the ball can't fall out of the arena.
+	void addDefaultArena();
+
 	// Pointers to objects needed in the class.
 	sf::RenderWindow* window;
 	Input* input;
@@ -121,21 +280,49 @@ private:
 	Lobby* lobby;
 	AudioManager* audio;
 
-	// Font and text objects.
-	sf::Font font;
-	sf::Text ping;
-	sf::Text score;
-	sf::Text time;
+	// Font, shared with the menus through the resource cache, and text objects.
+	std::shared_ptr<sf::Font> font;
+	// The ping, score and timer change during the match, so they are HUD text, which is only rebuilt when what it shows changes.
+	HudText ping;
+	HudText score;
+	HudText time;
 	sf::Text goal;
 
 	// Pointer to the player that is being controlled by the user.
 	Player* controlledPlayer;
 
-	// Player objects.
-	Player leftPlayer;
-	Player rightPlayer;
+	// Player objects, enough for the largest teams. The first teamSize are the left team and the next teamSize the right team.
+	std::vector<Player> players;
+	int teamSize;
+
+	// Which players this client simulates. Headless runs simulate everyone.
+	bool ownsLeftTeam;
+	bool ownsAllPlayers;
+
+	// Physics world, and each object's body in it. Player i's body is firstPlayerBody + i, straight after the ball, so the ball and players can go into the grid in one range.
+	PhysicsWorld world;
+	int ballBody;
+	int firstPlayerBody;
+
+	// Broadphase for finding which players touch the ball, and the pairs it found.
+	SpatialGrid grid;
+	std::vector<std::pair<int, int>> pairs;
 
-	// Collidable map boundaries and goalposts.
+	// Objects are collected into the snapshot's sprite batch each frame and drawn in as few draw calls as possible.
+	bool batchSprites;
+
+	// Random number generators for the power of each team's kicks, left team first. Each team draws only from its own, so kicks made at the same time on each client can't change the order of the draws.
+	Random kickRandom[2];
+
+	// The arena's colliders are loaded from the level description one after the other, so they can be tested in one go. One bit of the hits for each collider.
+	int arenaBody;
+	int arenaBodyCount;
+	std::vector<unsigned int> arenaHits;
+
+	// Size of the arena. The same as the window when playing.
+	sf::Vector2u arenaSize;
+
+	// Map boundaries and goalposts. These are only drawn - collisions use the colliders in the level description.
 	GameObject floor;
 	GameObject ceiling;
 	GameObject leftGoal;
@@ -144,9 +331,8 @@ private:
 	GameObject rightWall;
 
 	sf::RectangleShape ballBox;
-	// Ball object and texture.
+	// Ball object.
 	Ball ball;
-	sf::Texture ballSprite;
 
 	// Length of the match and a timer to keep track of game time.
 	float gameLength;
@@ -159,17 +345,16 @@ private:
 	// How often to perform physics calculations and a timer to keep track of this.
 	float physicsStep;
 	float physicsTimer;
+
+	// Most physics steps run in one update.
+	int maxPhysicsSteps;
 	
 	// Boolean for whether a goal has been scored and the variables for resetting the map afterwards.
 	bool goalScored;
 	float resetLength;
 	float resetTimer;
 
-	// Textures for each character and the goalposts.
-	sf::Texture messi;
-	sf::Texture ronaldo;
-	sf::Texture kirby;
-	sf::Texture miedema;
-	sf::Texture goalSprite;
+	// Atlas holding the ball, goalposts and every character, so the whole scene shares one texture.
+	TextureAtlas atlas;
 };
 
@@ -0,0 +1,738 @@
+#include "PhysicsWorld.h"
+
+// Maths functions are called unqualified, so they use the fixed point versions when Real is Fixed.
+using std::abs;
+using std::sqrt;
+using std::exp;
+using std::log;
+
+// Pick the widest instruction set the compiler has been told it can use. SSE2 is always available on x64, AVX needs /arch:AVX or /arch:AVX2. Fixed point has no vector version, so it always tests one body at a time.
+#if defined(PHYSICS_FIXED_POINT)
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define PHYSICS_AVX
+#define PHYSICS_SSE
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHYSICS_SSE
+#endif
+
+PhysicsWorld::PhysicsWorld()
+{
+	// Bodies rest on surfaces they are up to 10 pixels into.
+	restDepth = 10;
+	restSpeed = 50;
+	maxAdvanceContacts = 64;
+	advanceStep = 0;
+
+	contactCount = 0;
+}
+
+PhysicsWorld::~PhysicsWorld()
+{
+}
+
+int PhysicsWorld::addBody(sf::FloatRect box, unsigned char f)
+{
+	// Add an entry to every array, then set the box.
+	positionX.push_back(0);
+	positionY.push_back(0);
+	velocityX.push_back(0);
+	velocityY.push_back(0);
+	halfWidth.push_back(0);
+	halfHeight.push_back(0);
+	gravity.push_back(0);
+	drag.push_back(0);
+	restitutionTop.push_back(1);
+	restitutionBottom.push_back(1);
+	restitutionLeft.push_back(1);
+	restitutionRight.push_back(1);
+	flags.push_back(f);
+
+	int body = int(positionX.size()) - 1;
+	setBox(body, box);
+	return body;
+}
+
+void PhysicsWorld::clear()
+{
+	positionX.clear();
+	positionY.clear();
+	velocityX.clear();
+	velocityY.clear();
+	halfWidth.clear();
+	halfHeight.clear();
+	gravity.clear();
+	drag.clear();
+	restitutionTop.clear();
+	restitutionBottom.clear();
+	restitutionLeft.clear();
+	restitutionRight.clear();
+	flags.clear();
+}
+
+// Integrate every moving body in one pass over the arrays.
+void PhysicsWorld::integrate(Real dt)
+{
+	for (int i = 0; i < positionX.size(); i++)
+	{
+		if (!(flags[i] & STATIC))
+		{
+			integrate(i, dt);
+		}
+	}
+}
+
+void PhysicsWorld::integrate(int body, Real dt)
+{
+	applyForces(body, dt);
+
+	// Calculate position based on velocity.
+	positionX[body] += velocityX[body] * dt;
+	positionY[body] += velocityY[body] * dt;
+}
+
+void PhysicsWorld::applyForces(int body, Real dt)
+{
+	// Slow down along the x axis to simulate drag.
+	velocityX[body] -= velocityX[body] * drag[body] * dt;
+
+	// Resting bodies don't fall, otherwise increase y velocity by gravity.
+	if (flags[body] & RESTING)
+	{
+		velocityY[body] = 0;
+	}
+	else
+	{
+		velocityY[body] += gravity[body] * dt;
+	}
+}
+
+int PhysicsWorld::integrateSwept(int body, Real dt)
+{
+	applyForces(body, dt);
+
+	// Move up to the first face in the way, bounce off it, then carry on for the rest of the step.
+	contactCount = 0;
+	while (contactCount < maxContacts)
+	{
+		Real time;
+		Face face;
+		int hit = sweep(body, dt, time, face);
+		if (hit < 0)
+		{
+			break;
+		}
+
+		positionX[body] += velocityX[body] * time;
+		positionY[body] += velocityY[body] * time;
+		dt -= time;
+
+		switch (face)
+		{
+		case TOP:
+			velocityY[body] = -velocityY[body] * restitutionTop[hit];
+			break;
+		case BOTTOM:
+			velocityY[body] = -velocityY[body] * restitutionBottom[hit];
+			break;
+		case LEFT:
+			velocityX[body] = -velocityX[body] * restitutionLeft[hit];
+			break;
+		case RIGHT:
+			velocityX[body] = -velocityX[body] * restitutionRight[hit];
+			break;
+		default:
+			break;
+		}
+
+		contacts[contactCount].body = hit;
+		contacts[contactCount].face = face;
+		contactCount++;
+	}
+
+	positionX[body] += velocityX[body] * dt;
+	positionY[body] += velocityY[body] * dt;
+	return contactCount;
+}
+
+int PhysicsWorld::sweep(int body, Real dt, Real& time, Face& face)
+{
+	int hit = -1;
+	time = dt;
+	face = NO_FACE;
+
+	// Time used for an axis the body isn't moving along, further away than any step.
+	Real never = 1000000;
+
+	for (int i = 0; i < positionX.size(); i++)
+	{
+		if (!(flags[i] & STATIC))
+		{
+			continue;
+		}
+
+		// Treat the static body as a box grown by the moving body's half extents, so the moving body's centre can be swept as a ray.
+		// On each axis, work out when the centre enters and leaves the grown box. A body not moving on an axis is either always inside it or never.
+		Real gapX = positionX[i] - positionX[body];
+		Real gapY = positionY[i] - positionY[body];
+		Real width = halfWidth[i] + halfWidth[body];
+		Real height = halfHeight[i] + halfHeight[body];
+		Real enterX, exitX, enterY, exitY;
+
+		if (velocityX[body] != 0)
+		{
+			Real sign = velocityX[body] > 0 ? 1 : -1;
+			enterX = (gapX - sign * width) / velocityX[body];
+			exitX = (gapX + sign * width) / velocityX[body];
+		}
+		else if (abs(gapX) < width)
+		{
+			enterX = -never;
+			exitX = never;
+		}
+		else
+		{
+			continue;
+		}
+
+		if (velocityY[body] != 0)
+		{
+			Real sign = velocityY[body] > 0 ? 1 : -1;
+			enterY = (gapY - sign * height) / velocityY[body];
+			exitY = (gapY + sign * height) / velocityY[body];
+		}
+		else if (abs(gapY) < height)
+		{
+			enterY = -never;
+			exitY = never;
+		}
+		else
+		{
+			continue;
+		}
+
+		// The boxes touch from the later entry until the earlier exit. Skip bodies that are already overlapping, missed, or are reached after the earliest hit so far.
+		Real enter = std::max(enterX, enterY);
+		Real exit = std::min(exitX, exitY);
+		if (enter < 0 || enter > exit || enter > time || (hit >= 0 && enter == time))
+		{
+			continue;
+		}
+
+		// The face is on whichever axis was entered last. Only solid faces stop the body.
+		Face f;
+		unsigned char solid;
+		if (enterX > enterY)
+		{
+			f = velocityX[body] > 0 ? LEFT : RIGHT;
+			solid = velocityX[body] > 0 ? SOLID_LEFT : SOLID_RIGHT;
+		}
+		else
+		{
+			f = velocityY[body] > 0 ? TOP : BOTTOM;
+			solid = velocityY[body] > 0 ? SOLID_TOP : SOLID_BOTTOM;
+		}
+
+		if (flags[i] & solid)
+		{
+			hit = i;
+			time = enter;
+			face = f;
+		}
+	}
+
+	return hit;
+}
+
+void PhysicsWorld::overlapMask(int body, int first, int count, unsigned int* mask)
+{
+	// Clear the mask.
+	for (int i = 0; i < (count + 31) / 32; i++)
+	{
+		mask[i] = 0;
+	}
+
+	int i = 0;
+
+	// Each pass tests several bodies side by side: the gap between the centres on each axis (made positive by clearing the sign bit) must be no more than the half extents added together.
+	// Passes start on multiples of 4 or 8, so their bits never cross into the next word of the mask.
+#ifdef PHYSICS_SSE
+	float x = positionX[body];
+	float y = positionY[body];
+	float width = halfWidth[body];
+	float height = halfHeight[body];
+#endif
+
+#ifdef PHYSICS_AVX
+	__m256 x8 = _mm256_set1_ps(x);
+	__m256 y8 = _mm256_set1_ps(y);
+	__m256 width8 = _mm256_set1_ps(width);
+	__m256 height8 = _mm256_set1_ps(height);
+	__m256 sign8 = _mm256_set1_ps(-0.0f);
+
+	for (; i + 8 <= count; i += 8)
+	{
+		int j = first + i;
+		__m256 dx = _mm256_andnot_ps(sign8, _mm256_sub_ps(_mm256_loadu_ps(&positionX[j]), x8));
+		__m256 dy = _mm256_andnot_ps(sign8, _mm256_sub_ps(_mm256_loadu_ps(&positionY[j]), y8));
+		__m256 overlapX = _mm256_cmp_ps(dx, _mm256_add_ps(_mm256_loadu_ps(&halfWidth[j]), width8), _CMP_LE_OQ);
+		__m256 overlapY = _mm256_cmp_ps(dy, _mm256_add_ps(_mm256_loadu_ps(&halfHeight[j]), height8), _CMP_LE_OQ);
+
+		mask[i / 32] |= (unsigned int)_mm256_movemask_ps(_mm256_and_ps(overlapX, overlapY)) << (i % 32);
+	}
+#endif
+
+#ifdef PHYSICS_SSE
+	__m128 x4 = _mm_set1_ps(x);
+	__m128 y4 = _mm_set1_ps(y);
+	__m128 width4 = _mm_set1_ps(width);
+	__m128 height4 = _mm_set1_ps(height);
+	__m128 sign4 = _mm_set1_ps(-0.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		int j = first + i;
+		__m128 dx = _mm_andnot_ps(sign4, _mm_sub_ps(_mm_loadu_ps(&positionX[j]), x4));
+		__m128 dy = _mm_andnot_ps(sign4, _mm_sub_ps(_mm_loadu_ps(&positionY[j]), y4));
+		__m128 overlapX = _mm_cmple_ps(dx, _mm_add_ps(_mm_loadu_ps(&halfWidth[j]), width4));
+		__m128 overlapY = _mm_cmple_ps(dy, _mm_add_ps(_mm_loadu_ps(&halfHeight[j]), height4));
+
+		mask[i / 32] |= (unsigned int)_mm_movemask_ps(_mm_and_ps(overlapX, overlapY)) << (i % 32);
+	}
+#endif
+
+	// Test whatever is left one at a time.
+	for (; i < count; i++)
+	{
+		if (overlaps(body, first + i))
+		{
+			mask[i / 32] |= 1u << (i % 32);
+		}
+	}
+}
+
+void PhysicsWorld::overlapMasks(int firstBody, int bodyCount, int first, int count, unsigned int* masks)
+{
+	int words = (count + 31) / 32;
+	for (int i = 0; i < bodyCount; i++)
+	{
+		overlapMask(firstBody + i, first, count, masks + i * words);
+	}
+}
+
+bool PhysicsWorld::loadStaticBodies(std::string filename)
+{
+	std::string text;
+	if (!AssetArchive::getShared().loadText(text, filename))
+	{
+		std::cout << "Could not load level " << filename << ".\n";
+		return false;
+	}
+	std::istringstream file(text);
+
+	// Each line is: name, left, top, width, height, solid faces, restitution of the top, bottom, left and right faces, then any flags. Blank lines and lines starting with # are skipped.
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream stream(line);
+		std::string name;
+		if (!(stream >> name) || name[0] == '#')
+		{
+			continue;
+		}
+
+		sf::FloatRect box;
+		std::string faces;
+		float top, bottom, left, right;
+		if (!(stream >> box.left >> box.top >> box.width >> box.height >> faces >> top >> bottom >> left >> right))
+		{
+			std::cout << "Skipping bad collider " << name << " in " << filename << ".\n";
+			continue;
+		}
+
+		// Work out the flags from the faces and any extra words on the line.
+		unsigned char f = STATIC;
+		for (int i = 0; i < faces.size(); i++)
+		{
+			switch (faces[i])
+			{
+			case 'T':
+				f |= SOLID_TOP;
+				break;
+			case 'B':
+				f |= SOLID_BOTTOM;
+				break;
+			case 'L':
+				f |= SOLID_LEFT;
+				break;
+			case 'R':
+				f |= SOLID_RIGHT;
+				break;
+			default:
+				break;
+			}
+		}
+
+		std::string flag;
+		while (stream >> flag)
+		{
+			if (flag == "post")
+			{
+				f |= POST;
+			}
+		}
+
+		int body = addBody(box, f);
+		setRestitution(body, top, bottom, left, right);
+	}
+
+	return true;
+}
+
+PhysicsWorld::Face PhysicsWorld::resolve(int body, int staticBody, bool bounce)
+{
+	// How far the boxes overlap on each axis. Negative if they don't touch.
+	Real dx = positionX[body] - positionX[staticBody];
+	Real dy = positionY[body] - positionY[staticBody];
+	Real overlapX = halfWidth[body] + halfWidth[staticBody] - abs(dx);
+	Real overlapY = halfHeight[body] + halfHeight[staticBody] - abs(dy);
+
+	if (overlapX < 0 || overlapY < 0)
+	{
+		return NO_FACE;
+	}
+
+	// The body has gone in through whichever face it overlaps the least. Pick that face, and whether the body is moving into it.
+	Face face;
+	Real* velocity;
+	Real* position;
+	Real restitution;
+	bool movingIn;
+	unsigned char solid;
+
+	if (overlapX < overlapY)
+	{
+		face = dx < 0 ? LEFT : RIGHT;
+		velocity = &velocityX[body];
+		position = &positionX[body];
+		movingIn = dx < 0 ? *velocity > 0 : *velocity < 0;
+		solid = dx < 0 ? SOLID_LEFT : SOLID_RIGHT;
+		restitution = dx < 0 ? restitutionLeft[staticBody] : restitutionRight[staticBody];
+	}
+	else
+	{
+		face = dy < 0 ? TOP : BOTTOM;
+		velocity = &velocityY[body];
+		position = &positionY[body];
+		movingIn = dy < 0 ? *velocity > 0 : *velocity < 0;
+		solid = dy < 0 ? SOLID_TOP : SOLID_BOTTOM;
+		restitution = dy < 0 ? restitutionTop[staticBody] : restitutionBottom[staticBody];
+	}
+
+	if (!(flags[staticBody] & solid) || !movingIn)
+	{
+		return NO_FACE;
+	}
+
+	if (bounce)
+	{
+		*velocity = -*velocity * restitution;
+	}
+	else
+	{
+		// Stop, and move back out so the body sits against the face.
+		*velocity = 0;
+		if (face == LEFT || face == RIGHT)
+		{
+			*position += dx < 0 ? -overlapX : overlapX;
+		}
+		else
+		{
+			*position += dy < 0 ? -overlapY : overlapY;
+		}
+	}
+
+	return face;
+}
+
+bool PhysicsWorld::isResting(int body)
+{
+	return findSupport(body) >= 0;
+}
+
+int PhysicsWorld::findSupport(int body)
+{
+	// Resting on a static body with a solid top means being over it, with the bottom just inside its top or touching it. Swept bodies stop exactly on the top, so touching has to count.
+	Real bottom = positionY[body] + halfHeight[body];
+	for (int i = 0; i < positionX.size(); i++)
+	{
+		if (!(flags[i] & STATIC) || !(flags[i] & SOLID_TOP))
+		{
+			continue;
+		}
+
+		Real top = positionY[i] - halfHeight[i];
+		Real depth = std::max(halfHeight[i] * 2, restDepth);
+		if (abs(positionX[body] - positionX[i]) <= halfWidth[i] && bottom > top - 1 && bottom < top + 1 + depth)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+Real PhysicsWorld::dragRate(int body)
+{
+	// Each step keeps the same fraction of the velocity, which is an exponential decay at this rate when sampled once a step. A step losing all of its velocity can't be matched.
+	// The rate is -log(kept) / step. A step usually loses very little, so the log's series is used, as it is more precise than log() in fixed point.
+	Real lost = drag[body] * advanceStep;
+	if (advanceStep == 0 || lost <= 0 || lost >= 1)
+	{
+		return drag[body];
+	}
+	if (lost < Real(0.1f))
+	{
+		return drag[body] * (1 + lost / 2 + lost * lost / 3 + lost * lost * lost / 4);
+	}
+	return -log(1 - lost) / advanceStep;
+}
+
+Real PhysicsWorld::dragScale(int body)
+{
+	return 1 - drag[body] * advanceStep;
+}
+
+Real PhysicsWorld::travelX(int body, Real t)
+{
+	// Drag takes off a fixed fraction of the velocity every second, so the velocity decays exponentially.
+	// Stepping applies drag before moving, so each step moves at the velocity left after it. Summed over the steps, that is the continuous distance scaled by the fraction the first step keeps.
+	if (drag[body] == 0)
+	{
+		return velocityX[body] * t;
+	}
+	Real scale = dragScale(body) > 0 ? dragScale(body) : Real(1);
+	return velocityX[body] * scale * (1 - exp(-dragRate(body) * t)) / drag[body];
+}
+
+Real PhysicsWorld::travelY(int body, Real t)
+{
+	// Resting bodies don't fall.
+	if (flags[body] & RESTING)
+	{
+		return 0;
+	}
+
+	// Stepping applies gravity before moving, which falls an extra half step's worth of gravity each second compared to the continuous parabola.
+	return velocityY[body] * t + gravity[body] * t * (t + advanceStep) / 2;
+}
+
+Real PhysicsWorld::timeToTravelX(int body, Real distance)
+{
+	// Moving the wrong way, or not at all.
+	if (velocityX[body] == 0 || (distance > 0 && velocityX[body] < 0) || (distance < 0 && velocityX[body] > 0))
+	{
+		return -1;
+	}
+
+	if (drag[body] == 0)
+	{
+		return distance / velocityX[body];
+	}
+
+	// Inverse of travelX(). With drag, the body only ever covers a limited distance.
+	Real scale = dragScale(body) > 0 ? dragScale(body) : Real(1);
+	Real remaining = 1 - drag[body] * distance / (velocityX[body] * scale);
+	if (remaining <= 0)
+	{
+		return -1;
+	}
+	return -log(remaining) / dragRate(body);
+}
+
+void PhysicsWorld::move(int body, Real t)
+{
+	positionX[body] += travelX(body, t);
+	positionY[body] += travelY(body, t);
+	velocityX[body] *= exp(-dragRate(body) * t);
+	if (flags[body] & RESTING)
+	{
+		velocityY[body] = 0;
+	}
+	else
+	{
+		velocityY[body] += gravity[body] * t;
+	}
+}
+
+int PhysicsWorld::nextContact(int body, Real maxTime, int ignoreTop, Real& time, Face& face)
+{
+	int hit = -1;
+	time = maxTime;
+	face = NO_FACE;
+
+	Real x = positionX[body];
+	Real y = positionY[body];
+	bool resting = (flags[body] & RESTING) != 0;
+	Real a = resting ? Real(0) : gravity[body] / 2;
+	Real b = resting ? Real(0) : velocityY[body] + gravity[body] * advanceStep / 2;
+
+	for (int i = 0; i < positionX.size(); i++)
+	{
+		if (!(flags[i] & STATIC))
+		{
+			continue;
+		}
+
+		// As with sweep(), grow the static body by the moving body's half extents and follow the moving body's centre.
+		Real width = halfWidth[i] + halfWidth[body];
+		Real height = halfHeight[i] + halfHeight[body];
+
+		// Side faces. Only the face the body is moving towards can be reached, and the body must be level with the face when it gets there.
+		if (velocityX[body] != 0)
+		{
+			// A body that rounding has left less than a pixel past the face still reaches it straight away, rather than passing through.
+			bool right = velocityX[body] > 0;
+			Real distance = positionX[i] + (right ? -width : width) - x;
+			if (right ? distance < 0 && distance > -1 : distance > 0 && distance < 1)
+			{
+				distance = 0;
+			}
+			Real t = timeToTravelX(body, distance);
+			if (t >= 0 && t < time && (flags[i] & (right ? SOLID_LEFT : SOLID_RIGHT)) && abs(y + travelY(body, t) - positionY[i]) < height)
+			{
+				hit = i;
+				time = t;
+				face = right ? LEFT : RIGHT;
+			}
+		}
+
+		// Top and bottom faces. The body's height follows a parabola, so solve for when it crosses each face's line. Going down it crosses at the later root, going up at the earlier one.
+		for (int side = 0; side < 2; side++)
+		{
+			bool top = side == 0;
+			unsigned char solid = top ? SOLID_TOP : SOLID_BOTTOM;
+			if (!(flags[i] & solid) || (top && i == ignoreTop))
+			{
+				continue;
+			}
+
+			Real c = y - (positionY[i] + (top ? -height : height));
+			Real t = -1;
+			if (top ? b > 0 && c > 0 && c < 1 : b < 0 && c < 0 && c > -1)
+			{
+				t = 0;
+			}
+			else if (a == 0)
+			{
+				if (b != 0 && (b > 0) == top)
+				{
+					t = -c / b;
+				}
+			}
+			else
+			{
+				Real discriminant = b * b - 4 * a * c;
+				if (discriminant >= 0)
+				{
+					t = (-b + (top ? sqrt(discriminant) : -sqrt(discriminant))) / (2 * a);
+				}
+			}
+
+			if (t >= 0 && t < time && abs(x + travelX(body, t) - positionX[i]) < width)
+			{
+				hit = i;
+				time = t;
+				face = top ? TOP : BOTTOM;
+			}
+		}
+	}
+
+	// A resting body starts falling when its centre goes past either end of the body it is resting on.
+	if (resting)
+	{
+		int support = findSupport(body);
+		if (support >= 0 && velocityX[body] != 0)
+		{
+			Real edge = positionX[support] + (velocityX[body] > 0 ? halfWidth[support] : -halfWidth[support]);
+			Real t = timeToTravelX(body, edge - x);
+			if (t >= 0 && t < time)
+			{
+				hit = support;
+				time = t;
+				face = NO_FACE;
+			}
+		}
+	}
+
+	return hit;
+}
+
+bool PhysicsWorld::advance(int body, Real time)
+{
+	// Start resting if the body is already sitting on something and isn't moving up or down quickly. A body falling quickly onto a top bounces off it rather than stopping.
+	setFlag(body, RESTING, abs(velocityY[body]) < restSpeed && isResting(body));
+	int leaving = -1;
+	contactCount = 0;
+
+	for (int contact = 0; contact < maxAdvanceContacts; contact++)
+	{
+		Real t;
+		Face face;
+		int hit = nextContact(body, time, leaving, t, face);
+		if (hit < 0)
+		{
+			move(body, time);
+			return true;
+		}
+
+		move(body, t);
+		time -= t;
+		leaving = -1;
+
+		// Keep the first contacts, so that bouncing off a post during the catch up can still play its sound.
+		if (face != NO_FACE && contactCount < maxContacts)
+		{
+			contacts[contactCount].body = hit;
+			contacts[contactCount].face = face;
+			contactCount++;
+		}
+
+		// Bounce off the face that was reached, the same as integrateSwept(). Bouncing slowly off a top comes to rest on it, and leaving the end of a top starts falling.
+		switch (face)
+		{
+		case TOP:
+			velocityY[body] = -velocityY[body] * restitutionTop[hit];
+			if (-velocityY[body] < restSpeed)
+			{
+				// Landing slowly on a corner, with the centre past the end of the top, falls off it instead.
+				velocityY[body] = 0;
+				if (findSupport(body) >= 0)
+				{
+					setFlag(body, RESTING, true);
+				}
+				else
+				{
+					leaving = hit;
+				}
+			}
+			break;
+		case BOTTOM:
+			velocityY[body] = -velocityY[body] * restitutionBottom[hit];
+			break;
+		case LEFT:
+			velocityX[body] = -velocityX[body] * restitutionLeft[hit];
+			break;
+		case RIGHT:
+			velocityX[body] = -velocityX[body] * restitutionRight[hit];
+			break;
+		default:
+			setFlag(body, RESTING, false);
+			leaving = hit;
+			break;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,260 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "Fixed.h"
+#include "AssetArchive.h"
+
+// Physics world class. Holds the state of every physics body in separate arrays (structure of arrays) rather than inside each game object, which carry vertex arrays, textures and transforms.
+// Stepping or testing many bodies only touches the arrays it needs, so it stays cache friendly even with many bodies, such as many matches running on one server.
+// Bodies are referred to by their index. Positions are the centre of the body, and boxes are stored as half extents so overlap tests don't need any transforms.
+// State is stored as Real, which is float unless PHYSICS_FIXED_POINT is defined, in which case it is fixed point so every machine simulates exactly the same thing. Getters and setters use floats either way.
+// Static bodies (the arena) are loaded from a level description, from the asset archive if there is one. Each of their faces can be solid or not, with its own restitution, and resolve() handles any body against any of them.
+// Between contacts a body's motion is closed form (drag slows it exponentially along x, gravity accelerates it along y), so advance() can jump a body forward by any amount of time contact to contact, rather than stepping.
+// Given the step size used for stepping, the closed form is that of the stepped integrator, so advance() lands exactly where stepping would between contacts. Contacts still differ slightly, as stepping bounces part way through a step along a straight line, and a stepped body comes to rest as soon as it touches a top where advance() only rests once it is bouncing slower than restSpeed.
+// Fast bodies such as the ball can be moved with integrateSwept(), which sweeps the body's box along its path and bounces at the exact time of impact, so they can't pass through thin colliders however large the step is.
+class PhysicsWorld
+{
+public:
+	PhysicsWorld();
+	~PhysicsWorld();
+
+	// Flags for each body. Static bodies never move. Resting bodies aren't affected by gravity (for example the ball sitting on the floor).
+	// Solid faces are the sides of a static body that other bodies collide with. Post bodies play a sound when the ball hits their side.
+	enum Flags { STATIC = 1, RESTING = 2, SOLID_TOP = 4, SOLID_BOTTOM = 8, SOLID_LEFT = 16, SOLID_RIGHT = 32, POST = 64 };
+
+	// Enum for which face of a static body a collision was resolved against.
+	enum Face { NO_FACE = 0, TOP, BOTTOM, LEFT, RIGHT };
+
+	// Add a body with the given collision box. Returns the body's index.
+	int addBody(sf::FloatRect box, unsigned char flags);
+
+	// Add the static bodies listed in a level description file. Returns false if the file couldn't be read.
+	bool loadStaticBodies(std::string filename);
+
+	// Push a body out of a static body through the face it has gone into, if that face is solid and the body is moving into it.
+	// Bouncing bodies have their velocity reflected and scaled by the face's restitution. Other bodies are stopped and moved to sit against the face. Returns the face, or NO_FACE.
+	Face resolve(int body, int staticBody, bool bounce);
+
+	// Check whether a body is sitting on top of any static body, so it shouldn't fall.
+	bool isResting(int body);
+
+	// Find the static body that a body is sitting on top of, or -1 if there isn't one.
+	int findSupport(int body);
+
+	// Remove every body.
+	void clear();
+
+	// Move every body that isn't static forward by dt, or just the given body.
+	void integrate(Real dt);
+	void integrate(int body, Real dt);
+
+	// Move a body forward by dt, bouncing off the solid faces of static bodies it reaches on the way. Returns the number of contacts made during the step.
+	int integrateSwept(int body, Real dt);
+
+	// Find the first solid face of a static body that a body's box would reach if it moved at its current velocity for dt.
+	// Returns the static body, or -1 if there isn't one. The time until impact and the face are written to time and face. Bodies that already overlap are left to resolve().
+	int sweep(int body, Real dt, Real& time, Face& face);
+
+	// Move a body forward by time using the closed form of its motion, bouncing off solid faces and coming to rest on top of static bodies along the way.
+	// The cost depends on the number of contacts rather than the length of time. Returns false if the body made too many contacts to finish, in which case it is left at the last one.
+	bool advance(int body, Real time);
+
+	// Find when a body will next reach a solid face of a static body, or leave the top of the body it is resting on (NO_FACE), if that is within maxTime. Returns the static body, or -1 if there isn't one.
+	// The top of ignoreTop is skipped, so a body that has just rolled off the end of something doesn't land straight back on its corner.
+	int nextContact(int body, Real maxTime, int ignoreTop, Real& time, Face& face);
+
+	// Check whether two bodies' boxes overlap. Touching boxes count as overlapping.
+	bool overlaps(int a, int b)
+	{
+		using std::abs;
+		return abs(positionX[a] - positionX[b]) <= halfWidth[a] + halfWidth[b] && abs(positionY[a] - positionY[b]) <= halfHeight[a] + halfHeight[b];
+	};
+
+	// Check one body against a range of bodies at once, such as all of the arena's static bodies. Bit i of the mask is set if the body overlaps body first + i.
+	// The mask needs (count + 31) / 32 words. Uses AVX or SSE where the compiler has them enabled, and plain C++ otherwise.
+	void overlapMask(int body, int first, int count, unsigned int* mask);
+
+	// Same as above for up to 32 bodies, returning the mask.
+	unsigned int overlapMask(int body, int first, int count)
+	{
+		unsigned int mask = 0;
+		overlapMask(body, first, count, &mask);
+		return mask;
+	};
+
+	// Check a range of bodies against another range. Each body's mask is (count + 31) / 32 words long, one after the other.
+	void overlapMasks(int firstBody, int bodyCount, int first, int count, unsigned int* masks);
+
+	// Getter functions.
+	// ----
+	int getBodyCount()
+	{
+		return int(positionX.size());
+	};
+
+	sf::Vector2f getPosition(int body)
+	{
+		return sf::Vector2f(float(positionX[body]), float(positionY[body]));
+	};
+
+	sf::Vector2f getVelocity(int body)
+	{
+		return sf::Vector2f(float(velocityX[body]), float(velocityY[body]));
+	};
+
+	sf::Vector2f getHalfExtents(int body)
+	{
+		return sf::Vector2f(float(halfWidth[body]), float(halfHeight[body]));
+	};
+
+	// Collision box in the same layout as GameObject::getCollisionBox().
+	sf::FloatRect getBox(int body)
+	{
+		return sf::FloatRect(float(positionX[body] - halfWidth[body]), float(positionY[body] - halfHeight[body]), float(halfWidth[body] * 2), float(halfHeight[body] * 2));
+	};
+
+	bool getFlag(int body, Flags flag)
+	{
+		return (flags[body] & flag) != 0;
+	};
+
+	// Contacts made during the last call to integrateSwept() or advance(). advance() keeps its first maxContacts.
+	int getContactCount()
+	{
+		return contactCount;
+	};
+
+	int getContactBody(int contact)
+	{
+		return contacts[contact].body;
+	};
+
+	Face getContactFace(int contact)
+	{
+		return contacts[contact].face;
+	};
+	// ----
+
+	// Setter functions.
+	// ----
+	void setPosition(int body, sf::Vector2f position)
+	{
+		positionX[body] = position.x;
+		positionY[body] = position.y;
+	};
+
+	void setVelocity(int body, sf::Vector2f velocity)
+	{
+		velocityX[body] = velocity.x;
+		velocityY[body] = velocity.y;
+	};
+
+	// Move and resize a body to match a collision box.
+	void setBox(int body, sf::FloatRect box)
+	{
+		halfWidth[body] = Real(box.width) / 2;
+		halfHeight[body] = Real(box.height) / 2;
+		positionX[body] = Real(box.left) + halfWidth[body];
+		positionY[body] = Real(box.top) + halfHeight[body];
+	};
+
+	// Gravity (pixels per second squared) and drag (fraction of x velocity lost per second) applied when integrating.
+	void setGravity(int body, float g)
+	{
+		gravity[body] = g;
+	};
+
+	void setDrag(int body, float d)
+	{
+		drag[body] = d;
+	};
+
+	// Step size the bodies are stepped with, which advance() matches. Zero (the default) makes advance() use the exact continuous motion instead.
+	void setAdvanceStep(float s)
+	{
+		advanceStep = s;
+	};
+
+	// Fraction of speed kept when bouncing off each face of a static body.
+	void setRestitution(int body, float top, float bottom, float left, float right)
+	{
+		restitutionTop[body] = top;
+		restitutionBottom[body] = bottom;
+		restitutionLeft[body] = left;
+		restitutionRight[body] = right;
+	};
+
+	void setFlag(int body, Flags flag, bool set)
+	{
+		if (set)
+		{
+			flags[body] |= flag;
+		}
+		else
+		{
+			flags[body] &= ~flag;
+		}
+	};
+	// ----
+
+private:
+	// A static body and face that a swept body bounced off.
+	struct Contact
+	{
+		int body;
+		Face face;
+	};
+
+	// Apply drag and gravity to a body's velocity.
+	void applyForces(int body, Real dt);
+
+	// Rate the stepped integrator's drag slows a body by, as an exponential decay, and the fraction of velocity its first step keeps. With no step size these are the drag and 1.
+	Real dragRate(int body);
+	Real dragScale(int body);
+
+	// Closed form of a body's motion: how far it moves along each axis in time t, and the time it takes to move a distance along x (or -1 if it never gets there).
+	Real travelX(int body, Real t);
+	Real travelY(int body, Real t);
+	Real timeToTravelX(int body, Real distance);
+
+	// Move a body along its closed form path for time t, updating its velocity.
+	void move(int body, Real t);
+
+	// Body state, one entry per body in each array.
+	std::vector<Real> positionX;
+	std::vector<Real> positionY;
+	std::vector<Real> velocityX;
+	std::vector<Real> velocityY;
+	std::vector<Real> halfWidth;
+	std::vector<Real> halfHeight;
+	std::vector<Real> gravity;
+	std::vector<Real> drag;
+	std::vector<Real> restitutionTop;
+	std::vector<Real> restitutionBottom;
+	std::vector<Real> restitutionLeft;
+	std::vector<Real> restitutionRight;
+	std::vector<unsigned char> flags;
+
+	// How far a body can sink into the top of a static body and still rest on it.
+	Real restDepth;
+
+	// Bodies slower than this along y can start advance() resting, and a body that bounces off a top slower than this stops bouncing.
+	Real restSpeed;
+
+	// Step size that advance() matches.
+	Real advanceStep;
+
+	// Most contacts advance() will go through before giving up.
+	int maxAdvanceContacts;
+
+	// Contacts from the last swept step. A body can bounce at most maxContacts times in one step, which stops it getting stuck in a corner.
+	static const int maxContacts = 4;
+	Contact contacts[maxContacts];
+	int contactCount;
+};
@@ -26,13 +26,18 @@ Player::~Player()
 
 void Player::handleInput(float dt)
 {
+	// Inputs acted on are reported to the latency probe, which times each press from when it was pressed.
+	LatencyProbe& probe = LatencyProbe::getShared();
+
 	// If pressing A, move left. If pressing D, move right. If pressing neither. Don't move in x axis.
 	if (input->isKeyDown(sf::Keyboard::A))
 	{
+		probe.inputRead(LatencyProbe::key(sf::Keyboard::A));
 		velocity.x = -xSpeed;
 	}
 	else if (input->isKeyDown(sf::Keyboard::D))
 	{
+		probe.inputRead(LatencyProbe::key(sf::Keyboard::D));
 		velocity.x = xSpeed;
 	}
 	else
@@ -43,6 +48,8 @@ void Player::handleInput(float dt)
 	// If W or Space key is pressed, the player will jump.
 	if (input->isKeyDown(sf::Keyboard::W) || input->isKeyDown(sf::Keyboard::Space))
 	{
+		probe.inputRead(LatencyProbe::key(sf::Keyboard::W));
+		probe.inputRead(LatencyProbe::key(sf::Keyboard::Space));
 		input->setKeyUp(sf::Keyboard::W);
 		input->setKeyUp(sf::Keyboard::Space);
 
@@ -52,6 +59,8 @@ void Player::handleInput(float dt)
 	// If F is pressed or the left mouse button is clicked, kick if not already doing so.
 	if (input->isKeyDown(sf::Keyboard::F) || input->isMouseLDown())
 	{
+		probe.inputRead(LatencyProbe::key(sf::Keyboard::F));
+		probe.inputRead(LatencyProbe::mouseButton(sf::Mouse::Left));
 		input->setKeyUp(sf::Keyboard::F);
 		input->setMouseLDown(false);
 
@@ -62,6 +71,36 @@ void Player::handleInput(float dt)
 	}
 }
 
+void Player::chase(sf::Vector2f target, sf::Vector2f ball)
+{
+	// Run towards the target, stopping once close enough so the player doesn't jitter back and forth.
+	float distance = target.x - getCentre().x;
+	if (distance > 20)
+	{
+		velocity.x = xSpeed;
+	}
+	else if (distance < -20)
+	{
+		velocity.x = -xSpeed;
+	}
+	else
+	{
+		velocity.x = 0;
+	}
+
+	// Jump when the ball is overhead, and kick when it is close.
+	sf::Vector2f toBall = ball - getCentre();
+	if (std::abs(toBall.x) < 100 && toBall.y < -getSize().y && !jumping)
+	{
+		jump();
+	}
+
+	if (std::abs(toBall.x) < 120 && std::abs(toBall.y) < 120 && !kicking)
+	{
+		kick();
+	}
+}
+
 void Player::update(float dt)
 {
 	// Set direction based on velocity in x axis.
@@ -92,7 +131,7 @@ void Player::update(float dt)
 	}
 
 	// Right facing texture rectangle.
-	setTextureRect(sf::IntRect(0, 0, getTexture()->getSize().x, getTexture()->getSize().y));
+	setTextureRect(textureRegion);
 
 	// Flip the texture to face left if the player is facing left.
 	if (!facingRight) 
@@ -101,11 +140,11 @@ void Player::update(float dt)
 		setTextureRect(sf::IntRect(textureRect.left + textureRect.width, textureRect.top, -textureRect.width, textureRect.height));
 	}
 
-	// Increase player's y velocity by gravity.
-	velocity.y += gravity * gameScale * dt;
-
-	// Move player based on their velocity.
-	setPosition(getPosition().x + velocity.x * dt, getPosition().y + velocity.y * dt);
+	// Increase player's y velocity by gravity, then move player based on their velocity. Worked out in the physics' number type, so it matches on every machine when using fixed point.
+	// The result is rounded back to a float, as that is what the player stores, so with fixed point the player is only as precise as a float (see Fixed.h).
+	Real step = dt;
+	velocity.y = float(Real(velocity.y) + Real(gravity) * Real(gameScale) * step);
+	setPosition(float(Real(getPosition().x) + Real(velocity.x) * step), float(Real(getPosition().y) + Real(velocity.y) * step));
 }
 
 void Player::render()
@@ -139,7 +178,7 @@ void Player::setFacingRight(bool fr)
 {
 	// Set the direction that the player faces, then flip the texture if it's not facing right. Used for the other player as the update function is not called for them.
 	facingRight = fr;
-	setTextureRect(sf::IntRect(0, 0, getTexture()->getSize().x, getTexture()->getSize().y));
+	setTextureRect(textureRegion);
 
 	if (!facingRight)
 	{
@@ -148,3 +187,9 @@ void Player::setFacingRight(bool fr)
 	}
 }
 
+void Player::setSprite(const sf::Texture* texture, sf::IntRect region)
+{
+	setTexture(texture);
+	textureRegion = region;
+	setFacingRight(facingRight);
+}
@@ -1,5 +1,8 @@
 #pragma once
 #include "Framework/GameObject.h"
+#include <cmath>
+#include "Fixed.h"
+#include "LatencyProbe.h"
 // Player class.
 class Player : public GameObject
 {
@@ -9,7 +12,10 @@ public:
 
 	// Player's main functions.
 	void handleInput(float dt);
-	void update(float dt); // The player's update function is only called for the user's player. The other player will be manipulated using information sent by the other client.
+	void update(float dt); // The player's update function is only called for this client's team. The other team will be manipulated using information sent by the other client.
+
+	// Used instead of handling input for teammates that aren't controlled by the user. Runs towards the target, and jumps at and kicks the ball when close to it.
+	void chase(sf::Vector2f target, sf::Vector2f ball);
 	void render();
 
 	// Functions for the player's actions.
@@ -31,6 +37,9 @@ public:
 
 	void setFacingRight(bool fr);
 
+	// Set the player's texture and the region of it to use, such as a character in the texture atlas.
+	void setSprite(const sf::Texture* texture, sf::IntRect region);
+
 	bool getKicking()
 	{
 		return kicking;
@@ -53,6 +62,9 @@ private:
 	bool doubleJumping;
 	bool facingRight;
 
+	// Region of the texture the player's sprite is in. Flipped when facing left.
+	sf::IntRect textureRegion;
+
 	// Gravity and scale to be used for physics calculations.
 	float gravity;
 	float gameScale;
@@ -0,0 +1,36 @@
+#include "Random.h"
+
+Random::Random()
+{
+	seed(0, 0);
+}
+
+Random::~Random()
+{
+}
+
+void Random::seed(sf::Uint64 s, sf::Uint64 stream)
+{
+	// Set up in the same way as the reference PCG32, so the same seed and stream always give the same sequence.
+	state = 0;
+	increment = (stream << 1) | 1;
+	next();
+	state += s;
+	next();
+}
+
+sf::Uint32 Random::next()
+{
+	// Step the state along, then scramble the old state into the output: xor its high bits down, and rotate by an amount taken from its top bits.
+	sf::Uint64 old = state;
+	state = old * 6364136223846793005ULL + increment;
+	sf::Uint32 shifted = sf::Uint32(((old >> 18) ^ old) >> 27);
+	sf::Uint32 rotation = sf::Uint32(old >> 59);
+	return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+}
+
+int Random::range(int min, int max)
+{
+	// Scale the 32 bit number into the range with a multiply rather than %, which only uses the low bits.
+	return min + int((sf::Uint64(next()) * sf::Uint32(max - min)) >> 32);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <SFML/Config.hpp>
+
+// Random number generator (PCG32). Unlike rand(), the numbers it gives are fully defined by its seed, so two machines seeded the same way draw the same numbers, and its state can be saved and restored.
+// Each stream is a separate sequence for the same seed, so several generators can share one seed without drawing the same numbers.
+class Random
+{
+public:
+	Random();
+	~Random();
+
+	// Start the sequence for a seed and stream.
+	void seed(sf::Uint64 seed, sf::Uint64 stream);
+
+	// Next random number, using all 32 bits.
+	sf::Uint32 next();
+
+	// Random whole number from min up to, but not including, max.
+	int range(int min, int max);
+
+	// Getter and setter for the state. Setting the state carries on from where the generator it was taken from was, as long as they use the same stream.
+	// ----
+	sf::Uint64 getState()
+	{
+		return state;
+	};
+
+	void setState(sf::Uint64 s)
+	{
+		state = s;
+	};
+	// ----
+
+private:
+	// Position in the sequence, and the odd number added each step, which picks the stream.
+	sf::Uint64 state;
+	sf::Uint64 increment;
+};
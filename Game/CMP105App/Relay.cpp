@@ -0,0 +1,464 @@
+#include "Relay.h"
+
+Relay::Relay()
+{
+	// Buffer large enough for any datagram. Datagrams are forwarded straight out of this buffer so they are never copied into packets.
+	datagram.resize(sf::UdpSocket::MaxDatagramSize);
+
+	// Report forwarding statistics every 5 seconds.
+	reportRate = 5;
+
+	// Most connections at once. Further connections are turned away rather than left waiting. The operating system's limit on open sockets may be lower.
+	maxConnections = 10000;
+
+	// Set default values
+	// ----
+	forwardedDatagrams = 0;
+	forwardedPackets = 0;
+	totalForwardTime = 0;
+	maxForwardTime = 0;
+	rejectedConnections = 0;
+	// ----
+}
+
+Relay::~Relay()
+{
+}
+
+void Relay::run(unsigned short port)
+{
+	// Setup TCP listener and UDP socket on the same port. Neither block so that all pending connections and datagrams can be handled each time the poller wakes up.
+	if (tcpListener.listen(port) != sf::Socket::Done)
+	{
+		std::cout << "Relay could not listen on port " << port << ".\n";
+		return;
+	}
+
+	if (udpSocket.bind(port) != sf::Socket::Done)
+	{
+		std::cout << "Relay could not bind UDP socket to port " << port << ".\n";
+		return;
+	}
+
+	tcpListener.setBlocking(false);
+	udpSocket.setBlocking(false);
+
+	poller.add(tcpListener);
+	poller.add(udpSocket);
+
+	std::cout << "Relay running on port " << port << ".\n";
+	lastReport = std::chrono::steady_clock::now();
+
+	while (true)
+	{
+		// Wait until at least one socket has data or can send what it has queued, waking up regularly so that statistics are still reported when idle.
+		if (poller.wait(sf::seconds(1)))
+		{
+			if (poller.isReady(tcpListener))
+			{
+				acceptConnections();
+			}
+
+			// TCP first, so a join that arrived over TCP is known before the UDP join sent straight after it.
+			receiveTCP();
+
+			if (poller.isReady(udpSocket))
+			{
+				receiveUDP();
+			}
+		}
+
+		// Send what can be sent of each connection's queue, and only watch for being able to send while something is queued.
+		for (std::list<Connection>::iterator it = connections.begin(); it != connections.end(); ++it)
+		{
+			if (it->socket.hasQueued() && poller.isWritable(it->socket.getSocket()))
+			{
+				it->socket.flush();
+			}
+			poller.setWatchWritable(it->socket.getSocket(), it->socket.hasQueued());
+		}
+
+		removeClosedConnections();
+
+		if (std::chrono::steady_clock::now() - lastReport > std::chrono::duration<float>(reportRate))
+		{
+			report();
+		}
+	}
+}
+
+void Relay::acceptConnections()
+{
+	// Accept connections until there are none left waiting.
+	while (true)
+	{
+		connections.emplace_back();
+		Connection& connection = connections.back();
+		if (tcpListener.accept(connection.socket.getSocket()) != sf::Socket::Done)
+		{
+			connections.pop_back();
+			return;
+		}
+
+		// Turn the connection away once full. Closing it straight away lets the player know, instead of leaving them waiting to be accepted.
+		if (connections.size() > maxConnections)
+		{
+			connections.pop_back();
+			rejectedConnections++;
+			continue;
+		}
+
+		// Connection sockets don't block, so a slow player can't hold up the others. Sends that can't finish straight away are queued.
+		connection.socket.getSocket().setBlocking(false);
+		poller.add(connection.socket.getSocket());
+
+		connection.joined = false;
+		connection.matchID = 0;
+		connection.role = SPECTATOR;
+		connection.hasEndpoint = false;
+	}
+}
+
+void Relay::receiveTCP()
+{
+	// Go through each connection that has data waiting, and receive every whole packet that has arrived.
+	for (std::list<Connection>::iterator it = connections.begin(); it != connections.end(); ++it)
+	{
+		if (it->socket.isClosed() || !poller.isReady(it->socket.getSocket()))
+		{
+			continue;
+		}
+
+		sf::Packet packet;
+		sf::Socket::Status status = sf::Socket::NotReady;
+		while (!it->socket.isClosed() && (status = it->socket.receive(packet)) == sf::Socket::Done)
+		{
+			// The first packet a connection sends must be a join packet. Every packet after that is forwarded to the rest of the match.
+			if (!it->joined)
+			{
+				handleJoin(*it, packet);
+			}
+			else
+			{
+				forwardTCP(*it, packet);
+			}
+			packet.clear();
+		}
+
+		// Closed connections are removed from their match once every connection has been received from.
+		if (status == sf::Socket::Disconnected || status == sf::Socket::Error)
+		{
+			it->socket.close();
+		}
+	}
+}
+
+void Relay::removeClosedConnections()
+{
+	// Remove each closed connection from its match, then from the list, which disconnects it.
+	std::list<Connection>::iterator it = connections.begin();
+	while (it != connections.end())
+	{
+		if (it->socket.isClosed())
+		{
+			removeConnection(*it);
+			it = connections.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void Relay::receiveUDP()
+{
+	// Sender details.
+	std::size_t received;
+	sf::IpAddress sender;
+	unsigned short port;
+
+	// Receive datagrams until there are none left.
+	while (udpSocket.receive(datagram.data(), datagram.size(), received, sender, port) == sf::Socket::Done)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		// Look up which connection this endpoint belongs to. Unknown endpoints can only register themselves.
+		std::unordered_map<unsigned long long, Connection*>::iterator route = routes.find(routeKey(sender, port));
+		if (route == routes.end())
+		{
+			handleUDPJoin(datagram.data(), received, sender, port);
+			continue;
+		}
+
+		// A registered endpoint joining again hasn't had the confirmation yet, so confirm again rather than forwarding the join.
+		if (received >= 2 && ((unsigned char)datagram[0] << 8 | (unsigned char)datagram[1]) == NetworkManager::RELAY_JOIN)
+		{
+			sendRegistered(*route->second);
+			continue;
+		}
+
+		forwardUDP(*route->second, datagram.data(), received);
+
+		// Time taken to route and send the datagram is the latency the relay has added.
+		long long forwardTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		totalForwardTime += forwardTime;
+		if (forwardTime > maxForwardTime)
+		{
+			maxForwardTime = forwardTime;
+		}
+		forwardedDatagrams++;
+	}
+}
+
+void Relay::handleJoin(Connection& connection, sf::Packet packet)
+{
+	// Extract type, match and role from the packet.
+	unsigned short type;
+	unsigned int matchID;
+	unsigned short role;
+	if (!(packet >> type >> matchID >> role) || type != NetworkManager::RELAY_JOIN || role > SPECTATOR)
+	{
+		return;
+	}
+
+	// Find the match, creating it if this is the first connection to join.
+	Match& match = matches[matchID];
+
+	if (role == SPECTATOR)
+	{
+		match.spectators.push_back(&connection);
+	}
+	else
+	{
+		// Each peer slot can only be taken once. A peer can take the slot again after the previous connection has left.
+		// A peer reconnecting after losing its connection may get here before the relay has noticed the old connection has gone. If the slot is held from the same address, the old connection is taken to be stale and is replaced.
+		Connection* previous = match.peers[role];
+		if (previous != nullptr && previous->socket.getRemoteAddress() == connection.socket.getRemoteAddress())
+		{
+			std::cout << "Relay: replacing stale connection in match " << matchID << ".\n";
+			removeConnection(*previous);
+			previous->joined = false;
+			previous->hasEndpoint = false;
+			previous->socket.close();
+		}
+		else if (previous != nullptr)
+		{
+			// Someone else has the slot. Tell the player, rather than leaving them waiting to be paired, and close once told.
+			sf::Packet rejected;
+			unsigned short rejectedType = NetworkManager::RELAY_REJECTED;
+			rejected << rejectedType;
+			connection.socket.send(rejected);
+			connection.socket.closeWhenSent();
+			return;
+		}
+
+		// Removing the stale connection may have removed the match, so look it up again.
+		matches[matchID].peers[role] = &connection;
+	}
+
+	connection.joined = true;
+	connection.matchID = matchID;
+	connection.role = role;
+
+	// Once both peers are in the match, tell them both so they can start talking to each other.
+	Match& joined = matches[matchID];
+	if (joined.peers[HOST] != nullptr && joined.peers[CLIENT] != nullptr)
+	{
+		sf::Packet paired;
+		unsigned short pairedType = NetworkManager::RELAY_PAIRED;
+		paired << pairedType;
+
+		joined.peers[HOST]->socket.send(paired);
+		joined.peers[CLIENT]->socket.send(paired);
+	}
+}
+
+void Relay::handleUDPJoin(const char* data, std::size_t size, sf::IpAddress sender, unsigned short port)
+{
+	// Unknown endpoints are only accepted if they are registering for a connection that has already joined over TCP from the same address.
+	sf::Packet packet;
+	packet.append(data, size);
+
+	unsigned short type;
+	unsigned int matchID;
+	unsigned short role;
+	if (!(packet >> type >> matchID >> role) || type != NetworkManager::RELAY_JOIN || role > SPECTATOR)
+	{
+		return;
+	}
+
+	std::unordered_map<unsigned int, Match>::iterator match = matches.find(matchID);
+	if (match == matches.end())
+	{
+		return;
+	}
+
+	// Find the connection the endpoint belongs to.
+	Connection* connection = nullptr;
+	if (role == SPECTATOR)
+	{
+		for (int i = 0; i < match->second.spectators.size(); i++)
+		{
+			if (match->second.spectators[i]->socket.getRemoteAddress() == sender && !match->second.spectators[i]->hasEndpoint)
+			{
+				connection = match->second.spectators[i];
+				break;
+			}
+		}
+	}
+	else if (match->second.peers[role] != nullptr && match->second.peers[role]->socket.getRemoteAddress() == sender)
+	{
+		connection = match->second.peers[role];
+	}
+
+	if (connection == nullptr)
+	{
+		return;
+	}
+
+	// If the connection had already registered an endpoint (for example its NAT mapping changed), replace the old route.
+	if (connection->hasEndpoint)
+	{
+		routes.erase(routeKey(connection->endpoint.ip, connection->endpoint.port));
+	}
+
+	connection->hasEndpoint = true;
+	connection->endpoint.ip = sender;
+	connection->endpoint.port = port;
+	routes[routeKey(sender, port)] = connection;
+
+	sendRegistered(*connection);
+}
+
+void Relay::sendRegistered(Connection& connection)
+{
+	// Confirm over TCP that the endpoint is registered, so the player stops sending UDP joins.
+	sf::Packet packet;
+	unsigned short type = NetworkManager::RELAY_REGISTERED;
+	packet << type;
+	connection.socket.send(packet);
+}
+
+void Relay::forwardTCP(Connection& connection, sf::Packet& packet)
+{
+	// Spectators only receive.
+	if (connection.role == SPECTATOR)
+	{
+		return;
+	}
+
+	Match& match = matches[connection.matchID];
+
+	// Send to the other peer, then to every spectator.
+	Connection* other = match.peers[1 - connection.role];
+	if (other != nullptr)
+	{
+		other->socket.send(packet);
+	}
+
+	for (int i = 0; i < match.spectators.size(); i++)
+	{
+		match.spectators[i]->socket.send(packet);
+	}
+
+	forwardedPackets++;
+}
+
+void Relay::forwardUDP(Connection& connection, const char* data, std::size_t size)
+{
+	// Spectators only receive.
+	if (connection.role == SPECTATOR)
+	{
+		return;
+	}
+
+	Match& match = matches[connection.matchID];
+
+	// Send the datagram as it was received to the other peer, then to every spectator.
+	Connection* other = match.peers[1 - connection.role];
+	if (other != nullptr && other->hasEndpoint)
+	{
+		udpSocket.send(data, size, other->endpoint.ip, other->endpoint.port);
+	}
+
+	for (int i = 0; i < match.spectators.size(); i++)
+	{
+		if (match.spectators[i]->hasEndpoint)
+		{
+			udpSocket.send(data, size, match.spectators[i]->endpoint.ip, match.spectators[i]->endpoint.port);
+		}
+	}
+}
+
+void Relay::removeConnection(Connection& connection)
+{
+	poller.remove(connection.socket.getSocket());
+
+	// Remove the connection's UDP route.
+	if (connection.hasEndpoint)
+	{
+		routes.erase(routeKey(connection.endpoint.ip, connection.endpoint.port));
+	}
+
+	if (!connection.joined)
+	{
+		return;
+	}
+
+	Match& match = matches[connection.matchID];
+
+	if (connection.role == SPECTATOR)
+	{
+		for (int i = 0; i < match.spectators.size(); i++)
+		{
+			if (match.spectators[i] == &connection)
+			{
+				match.spectators.erase(match.spectators.begin() + i);
+				break;
+			}
+		}
+	}
+	else
+	{
+		// Free the peer's slot and let the other peer know, so it can go back to waiting in the lobby.
+		match.peers[connection.role] = nullptr;
+
+		Connection* other = match.peers[1 - connection.role];
+		if (other != nullptr)
+		{
+			sf::Packet packet;
+			unsigned short type = NetworkManager::RELAY_PEER_LEFT;
+			packet << type;
+			other->socket.send(packet);
+		}
+	}
+
+	// Remove the match once everyone has left.
+	if (match.peers[HOST] == nullptr && match.peers[CLIENT] == nullptr && match.spectators.empty())
+	{
+		matches.erase(connection.matchID);
+	}
+}
+
+void Relay::report()
+{
+	// Average latency added per datagram, in microseconds.
+	long long averageForwardTime = 0;
+	if (forwardedDatagrams > 0)
+	{
+		averageForwardTime = totalForwardTime / forwardedDatagrams;
+	}
+
+	std::cout << "Relay: " << matches.size() << " matches, " << connections.size() << " connections (" << rejectedConnections << " turned away), "
+		<< forwardedDatagrams << " datagrams and " << forwardedPackets << " packets forwarded in the last " << reportRate << "s. "
+		<< "Added latency: " << averageForwardTime << "us average, " << maxForwardTime << "us max.\n";
+
+	// Reset statistics for the next report.
+	lastReport = std::chrono::steady_clock::now();
+	forwardedDatagrams = 0;
+	forwardedPackets = 0;
+	totalForwardTime = 0;
+	maxForwardTime = 0;
+	rejectedConnections = 0;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <iostream>
+#include <chrono>
+#include <list>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "NetworkManager.h"
+#include "SocketPoller.h"
+#include "BufferedSocket.h"
+
+// Relay class. Runs as its own process (started with "-relay-server <port>") so that players behind NAT can still play, as both peers only ever connect outbound to the relay.
+// Each match has a routing table of its two peers and any number of spectators. TCP packets are forwarded as whole packets, UDP datagrams are forwarded as raw bytes without being unpacked.
+// Sockets don't block and are watched with a socket poller, so the relay can serve thousands of matches without one slow player holding up the rest. Past maxConnections, new connections are turned away.
+// The relay reports the latency it adds to forwarded datagrams every few seconds.
+class Relay
+{
+public:
+	Relay();
+	~Relay();
+
+	// Start the relay on the given port. The TCP listener and UDP socket share the same port number, the same as the game does. Runs until the process is closed.
+	void run(unsigned short port);
+
+private:
+	// Roles a connection can join a match with. The host and client are the two peers, spectators only receive.
+	enum Role { HOST = 0, CLIENT, SPECTATOR };
+
+	// A UDP endpoint (IP and port).
+	struct Endpoint
+	{
+		sf::IpAddress ip;
+		unsigned short port;
+	};
+
+	// A TCP connection to the relay, and the UDP endpoint it registered once it has joined a match.
+	struct Connection
+	{
+		BufferedSocket socket;
+		bool joined;
+		unsigned int matchID;
+		unsigned short role;
+		bool hasEndpoint;
+		Endpoint endpoint;
+	};
+
+	// Routing table for a single match. Slot 0 is the host and slot 1 is the client.
+	struct Match
+	{
+		Connection* peers[2];
+		std::vector<Connection*> spectators;
+	};
+
+	// Functions for handling new connections, packets and disconnects.
+	void acceptConnections();
+	void receiveTCP();
+	void receiveUDP();
+	void handleJoin(Connection& connection, sf::Packet packet);
+	void handleUDPJoin(const char* data, std::size_t size, sf::IpAddress sender, unsigned short port);
+	void sendRegistered(Connection& connection);
+	void forwardTCP(Connection& connection, sf::Packet& packet);
+	void forwardUDP(Connection& connection, const char* data, std::size_t size);
+	void removeConnection(Connection& connection);
+	void removeClosedConnections();
+
+	// Function for printing the forwarding statistics.
+	void report();
+
+	// Key used for looking up the route for an endpoint.
+	unsigned long long routeKey(sf::IpAddress ip, unsigned short port)
+	{
+		return (unsigned long long)ip.toInteger() << 16 | port;
+	};
+
+	// Listener, UDP socket and poller used to wait for incoming data on all sockets at once.
+	sf::TcpListener tcpListener;
+	sf::UdpSocket udpSocket;
+	SocketPoller poller;
+
+	// Most connections at once, and how many have been turned away since the last report.
+	std::size_t maxConnections;
+	unsigned long long rejectedConnections;
+
+	// All TCP connections, and the routing tables for each match and each UDP endpoint.
+	std::list<Connection> connections;
+	std::unordered_map<unsigned int, Match> matches;
+	std::unordered_map<unsigned long long, Connection*> routes;
+
+	// Buffer that UDP datagrams are received into and forwarded from.
+	std::vector<char> datagram;
+
+	// Forwarding statistics since the last report.
+	std::chrono::steady_clock::time_point lastReport;
+	float reportRate;
+	unsigned long long forwardedDatagrams;
+	unsigned long long forwardedPackets;
+	long long totalForwardTime;
+	long long maxForwardTime;
+};
@@ -0,0 +1,128 @@
+#include "RenderSnapshot.h"
+#include "ResourceCache.h"
+
+RenderSnapshot::RenderSnapshot()
+{
+	shapeCount = 0;
+	spriteCount = 0;
+	textCount = 0;
+	hudTextCount = 0;
+	batchCount = 0;
+	clearColour = sf::Color::Black;
+	drawCalls = 0;
+	step = 0;
+}
+
+RenderSnapshot::~RenderSnapshot()
+{
+}
+
+void RenderSnapshot::clear(sf::Color colour, const sf::View& v)
+{
+	items.clear();
+	shapeCount = 0;
+	spriteCount = 0;
+	textCount = 0;
+	hudTextCount = 0;
+	batchCount = 0;
+	clearColour = colour;
+	view = v;
+}
+
+void RenderSnapshot::draw(const sf::RectangleShape& shape)
+{
+	Item item = { Type::SHAPE, shapeCount };
+	next(shapes, shapeCount) = shape;
+	items.push_back(item);
+}
+
+void RenderSnapshot::draw(const sf::Sprite& sprite)
+{
+	Item item = { Type::SPRITE, spriteCount };
+	next(sprites, spriteCount) = sprite;
+	items.push_back(item);
+}
+
+void RenderSnapshot::draw(const sf::Text& text)
+{
+	// Text builds its glyphs when it is first drawn or measured. Measuring it here builds them while recording, so drawing the copy usually only has to look up the font's texture. It still reads the font, so it is drawn holding the font lock.
+	text.getLocalBounds();
+
+	Item item = { Type::TEXT, textCount };
+	next(texts, textCount) = text;
+	items.push_back(item);
+}
+
+void RenderSnapshot::draw(const HudText& text)
+{
+	Item item = { Type::HUD_TEXT, hudTextCount };
+	next(hudTexts, hudTextCount) = text;
+	items.push_back(item);
+}
+
+void RenderSnapshot::batch(const sf::Shape& shape)
+{
+	// Start a new batch unless the last thing recorded was batched.
+	if (items.empty() || items.back().type != Type::BATCH)
+	{
+		Item item = { Type::BATCH, batchCount };
+		next(batches, batchCount).clear();
+		items.push_back(item);
+	}
+
+	batches[items.back().index].add(shape);
+}
+
+int RenderSnapshot::getDrawCalls(const sf::Text& text)
+{
+	// Text draws its outline and its fill separately, and nothing if it has no font or string.
+	if (!text.getFont() || text.getString().isEmpty())
+	{
+		return 0;
+	}
+	return text.getOutlineThickness() != 0 ? 2 : 1;
+}
+
+void RenderSnapshot::render(sf::RenderTarget& target)
+{
+	drawCalls = 0;
+	target.setView(view);
+	target.clear(clearColour);
+
+	// Text reads its font as it is drawn, so it is drawn holding the font lock, in case the main thread is measuring text at the same time.
+	std::mutex& fontMutex = ResourceCache::getShared().getFontMutex();
+
+	for (int i = 0; i < items.size(); i++)
+	{
+		int index = items[i].index;
+		switch (items[i].type)
+		{
+		case Type::SHAPE:
+			target.draw(shapes[index]);
+			drawCalls++;
+			break;
+		case Type::SPRITE:
+			target.draw(sprites[index]);
+			drawCalls++;
+			break;
+		case Type::TEXT:
+		{
+			std::lock_guard<std::mutex> lock(fontMutex);
+			target.draw(texts[index]);
+			drawCalls += getDrawCalls(texts[index]);
+			break;
+		}
+		case Type::HUD_TEXT:
+		{
+			std::lock_guard<std::mutex> lock(fontMutex);
+			target.draw(hudTexts[index]);
+			drawCalls += hudTexts[index].getDrawCalls();
+			break;
+		}
+		case Type::BATCH:
+			batches[index].draw(target);
+			drawCalls += batches[index].getDrawCalls();
+			break;
+		}
+	}
+}
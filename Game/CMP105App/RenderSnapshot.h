@@ -0,0 +1,95 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "SpriteBatch.h"
+#include "HudText.h"
+
+// Render snapshot class. Records everything drawn in a frame by copying each object, so the frame can be drawn later, on another thread, while the game carries on changing the objects for the next one.
+// Objects are drawn in the order they are recorded. Batched shapes go into a sprite batch, and consecutive ones are drawn together in the same way as the sprite batch on its own.
+// Copies are kept from frame to frame and assigned over, so once a snapshot has grown to fit a frame, recording the next one doesn't need to allocate.
+class RenderSnapshot
+{
+public:
+	RenderSnapshot();
+	~RenderSnapshot();
+
+	// Empty the snapshot, ready to record a frame that is cleared to the given colour and drawn with the given view.
+	void clear(sf::Color colour, const sf::View& view);
+
+	// Record an object being drawn on its own.
+	// ----
+	void draw(const sf::RectangleShape& shape);
+	void draw(const sf::Sprite& sprite);
+	void draw(const sf::Text& text);
+	void draw(const HudText& text);
+	// ----
+
+	// Record a shape's fill into the sprite batch.
+	void batch(const sf::Shape& shape);
+
+	// Clear the target and draw the recorded frame. Doesn't change what was recorded, so the same frame can be drawn again.
+	void render(sf::RenderTarget& target);
+
+	// Number of draw calls made by the last call to render().
+	int getDrawCalls()
+	{
+		return drawCalls;
+	};
+
+	// Physics step the frame was recorded after, used by the latency probe to tell which presses it shows.
+	// ----
+	void setStep(sf::Uint64 s)
+	{
+		step = s;
+	};
+
+	sf::Uint64 getStep()
+	{
+		return step;
+	};
+	// ----
+
+private:
+	// Kinds of object that can be recorded.
+	enum class Type { SHAPE, SPRITE, TEXT, HUD_TEXT, BATCH };
+
+	// An object to draw: its kind, and which copy of that kind it is.
+	struct Item
+	{
+		Type type;
+		int index;
+	};
+
+	// Draw calls drawing a text object makes.
+	static int getDrawCalls(const sf::Text& text);
+
+	// Get the next copy of a kind of object to assign over, adding one if every copy is in use.
+	template <typename T>
+	T& next(std::vector<T>& copies, int& count)
+	{
+		if (count == copies.size())
+		{
+			copies.push_back(T());
+		}
+		return copies[count++];
+	};
+
+	std::vector<Item> items;
+
+	// Copies of each kind of object, and how many of each are in use this frame.
+	std::vector<sf::RectangleShape> shapes;
+	std::vector<sf::Sprite> sprites;
+	std::vector<sf::Text> texts;
+	std::vector<HudText> hudTexts;
+	std::vector<SpriteBatch> batches;
+	int shapeCount;
+	int spriteCount;
+	int textCount;
+	int hudTextCount;
+	int batchCount;
+
+	sf::Color clearColour;
+	sf::View view;
+	int drawCalls;
+	sf::Uint64 step;
+};
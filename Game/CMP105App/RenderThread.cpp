@@ -0,0 +1,81 @@
+#include "RenderThread.h"
+
+RenderThread::RenderThread(sf::RenderWindow* hwnd)
+{
+	window = hwnd;
+	recording = 0;
+	newest = 1;
+	drawing = 2;
+	fresh = false;
+	stopping = false;
+	framesPresented = 0;
+	framesDropped = 0;
+
+	// A context can only be active on one thread at a time, so release the window's before the render thread takes it.
+	window->setActive(false);
+	thread = std::thread(&RenderThread::run, this);
+}
+
+RenderThread::~RenderThread()
+{
+	stop();
+}
+
+void RenderThread::publish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (fresh)
+		{
+			framesDropped++;
+		}
+		std::swap(recording, newest);
+		fresh = true;
+	}
+	frameReady.notify_one();
+}
+
+void RenderThread::stop()
+{
+	if (!thread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	frameReady.notify_one();
+	thread.join();
+
+	window->setActive(true);
+}
+
+void RenderThread::run()
+{
+	window->setActive(true);
+
+	while (true)
+	{
+		// Wait for a new frame, then take it.
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			frameReady.wait(lock, [this]() { return fresh || stopping; });
+			if (stopping)
+			{
+				break;
+			}
+			std::swap(newest, drawing);
+			fresh = false;
+		}
+
+		// Drawing and displaying, which can wait for the display, happen without holding the lock, so the main thread can publish the next frame meanwhile.
+		snapshots[drawing].render(*window);
+		window->display();
+		framesPresented++;
+		LatencyProbe::getShared().framePresented(snapshots[drawing].getStep());
+	}
+
+	window->setActive(false);
+}
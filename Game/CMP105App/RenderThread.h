@@ -0,0 +1,69 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "RenderSnapshot.h"
+#include "LatencyProbe.h"
+
+// Render thread class. Draws frames to the window on its own thread, so a slow frame or waiting for the display doesn't hold up the physics, networking and input on the main thread.
+// The main thread records each frame into a snapshot and publishes it. There are three snapshots: one being recorded, the newest published one, and one being drawn.
+// Publishing swaps the recorded snapshot with the newest one, so the main thread never waits. If the render thread falls behind, frames it hasn't started are replaced by newer ones rather than queued, so what's shown is never more than a frame old.
+// The window's OpenGL context belongs to the render thread while it runs, so the window must only be drawn to through snapshots, and stop() must be called before the window is closed.
+// Fonts are shared with the main thread, so text is drawn holding the resource cache's font lock, and the main thread holds it whenever it might measure text.
+class RenderThread
+{
+public:
+	RenderThread(sf::RenderWindow* hwnd);
+	~RenderThread();
+
+	// Snapshot for the main thread to record the next frame into.
+	RenderSnapshot& getSnapshot()
+	{
+		return snapshots[recording];
+	};
+
+	// Hand the recorded frame to the render thread to draw next, and start recording into another snapshot.
+	void publish();
+
+	// Finish the frame being drawn and stop the thread, giving the window back to the main thread. Does nothing if it has already stopped.
+	void stop();
+
+	// Getter functions for how many frames have been drawn, and how many were replaced by newer ones before they could be.
+	// ----
+	int getFramesPresented()
+	{
+		return framesPresented;
+	};
+
+	int getFramesDropped()
+	{
+		return framesDropped;
+	};
+	// ----
+
+private:
+	// Function run by the thread. Draws the newest published frame whenever there is one.
+	void run();
+
+	sf::RenderWindow* window;
+	std::thread thread;
+
+	// The three snapshots, and which is being recorded, newest and being drawn. Only the indices are swapped, and only while holding mutex.
+	RenderSnapshot snapshots[3];
+	int recording;
+	int newest;
+	int drawing;
+
+	// Whether the newest snapshot hasn't been drawn yet, and whether the thread should stop.
+	bool fresh;
+	bool stopping;
+
+	// Frames drawn is counted by the render thread, so it is atomic. Frames dropped is only changed while holding mutex.
+	std::atomic<int> framesPresented;
+	int framesDropped;
+
+	std::mutex mutex;
+	std::condition_variable frameReady;
+};
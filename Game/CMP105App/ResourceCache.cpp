@@ -0,0 +1,84 @@
+#include "ResourceCache.h"
+
+ResourceCache::ResourceCache()
+{
+	loadCount = 0;
+	bytesLoaded = 0;
+}
+
+ResourceCache::~ResourceCache()
+{
+}
+
+ResourceCache& ResourceCache::getShared()
+{
+	static ResourceCache cache;
+	return cache;
+}
+
+std::shared_ptr<sf::Texture> ResourceCache::getTexture(std::string filename)
+{
+	// Hand out the loaded copy if anything still holds it.
+	std::shared_ptr<sf::Texture> texture = textures[filename].lock();
+	if (texture)
+	{
+		return texture;
+	}
+
+	texture = std::make_shared<sf::Texture>();
+	if (!AssetArchive::getShared().loadTexture(*texture, filename))
+	{
+		std::cout << "Could not load texture " << filename << ".\n";
+	}
+	textures[filename] = texture;
+
+	loadCount++;
+	bytesLoaded += std::size_t(texture->getSize().x) * texture->getSize().y * 4;
+	return texture;
+}
+
+std::shared_ptr<sf::Texture> ResourceCache::getTexture(std::string filename, const sf::Image& image)
+{
+	std::shared_ptr<sf::Texture> texture = textures[filename].lock();
+	if (texture)
+	{
+		return texture;
+	}
+
+	texture = std::make_shared<sf::Texture>();
+	if (!texture->loadFromImage(image))
+	{
+		std::cout << "Could not load texture " << filename << ".\n";
+	}
+	textures[filename] = texture;
+
+	loadCount++;
+	bytesLoaded += std::size_t(texture->getSize().x) * texture->getSize().y * 4;
+	return texture;
+}
+
+std::shared_ptr<sf::Font> ResourceCache::getFont(std::string filename)
+{
+	std::shared_ptr<sf::Font> font = fonts[filename].lock();
+	if (font)
+	{
+		return font;
+	}
+
+	font = std::make_shared<sf::Font>();
+	if (!AssetArchive::getShared().loadFont(*font, filename))
+	{
+		std::cout << "Could not load font " << filename << ".\n";
+	}
+	fonts[filename] = font;
+
+	loadCount++;
+	bytesLoaded += AssetArchive::getShared().getFileSize(filename);
+	return font;
+}
+
+std::size_t ResourceCache::getFileSize(std::string filename)
+{
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	return file ? std::size_t(file.tellg()) : 0;
+}
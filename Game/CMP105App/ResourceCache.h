@@ -0,0 +1,60 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "AssetArchive.h"
+
+// Resource cache class. Loads each texture and font once, keyed by file path, and hands out shared handles to it, so objects using the same file share one copy instead of each decoding and uploading their own.
+// Files are read from the asset archive if there is one. The cache only keeps weak references. A resource is freed when the last handle to it is dropped, and loaded again if it is asked for after that.
+class ResourceCache
+{
+public:
+	ResourceCache();
+	~ResourceCache();
+
+	// Cache shared by the whole game. The menus and object manager load their resources in their constructors, before anything can be passed to them, so they use this one.
+	static ResourceCache& getShared();
+
+	// Get a handle to a texture or font, loading it if it isn't already loaded. A resource that fails to load is still returned, empty, so it can be used safely.
+	std::shared_ptr<sf::Texture> getTexture(std::string filename);
+	std::shared_ptr<sf::Font> getFont(std::string filename);
+
+	// Get a handle to a texture, creating it from an image already decoded from the file if it isn't already loaded. Used by the asset loader, which decodes files in the background.
+	std::shared_ptr<sf::Texture> getTexture(std::string filename, const sf::Image& image);
+
+	// Getter functions for how many files have been loaded, and roughly how much memory they took: four bytes a pixel for textures, and the file size for fonts.
+	// ----
+	int getLoadCount()
+	{
+		return loadCount;
+	};
+
+	std::size_t getBytesLoaded()
+	{
+		return bytesLoaded;
+	};
+	// ----
+
+	// Size of a file in bytes, or 0 if it can't be opened.
+	static std::size_t getFileSize(std::string filename);
+
+	// Lock for using fonts. A font renders glyphs into its texture the first time they are needed, when text is measured or drawn, and isn't safe to use from two threads at once.
+	// The main thread holds it while updating and recording a frame, and the render thread while drawing text.
+	std::mutex& getFontMutex()
+	{
+		return fontMutex;
+	};
+
+private:
+	std::map<std::string, std::weak_ptr<sf::Texture>> textures;
+	std::map<std::string, std::weak_ptr<sf::Font>> fonts;
+
+	int loadCount;
+	std::size_t bytesLoaded;
+
+	std::mutex fontMutex;
+};
@@ -0,0 +1,112 @@
+#include "SocketPoller.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+typedef WSAPOLLFD PollEntry;
+#else
+#include <poll.h>
+typedef pollfd PollEntry;
+#endif
+
+namespace
+{
+	// sf::Socket only lets classes derived from it get its handle. A pointer to the member taken through a derived class can be used on any socket.
+	struct SocketHandleAccess : sf::Socket
+	{
+		static sf::SocketHandle get(const sf::Socket& socket)
+		{
+			return (socket.*(&SocketHandleAccess::getHandle))();
+		}
+	};
+}
+
+SocketPoller::SocketPoller()
+{
+	static_assert(sizeof(Entry) == sizeof(PollEntry), "Entry must be laid out the same as the platform's poll entry.");
+}
+
+SocketPoller::~SocketPoller()
+{
+}
+
+void SocketPoller::add(sf::Socket& socket)
+{
+	sf::SocketHandle handle = SocketHandleAccess::get(socket);
+	if (indices.count(handle) != 0)
+	{
+		return;
+	}
+
+	Entry entry = { handle, POLLIN, 0 };
+	indices[handle] = entries.size();
+	entries.push_back(entry);
+}
+
+void SocketPoller::remove(sf::Socket& socket)
+{
+	std::unordered_map<sf::SocketHandle, std::size_t>::iterator it = indices.find(SocketHandleAccess::get(socket));
+	if (it == indices.end())
+	{
+		return;
+	}
+
+	// Move the last entry into the removed one's place.
+	std::size_t index = it->second;
+	indices.erase(it);
+	if (index != entries.size() - 1)
+	{
+		entries[index] = entries.back();
+		indices[entries[index].handle] = index;
+	}
+	entries.pop_back();
+}
+
+void SocketPoller::setWatchWritable(sf::Socket& socket, bool watch)
+{
+	Entry* entry = find(socket);
+	if (entry)
+	{
+		entry->events = watch ? (POLLIN | POLLOUT) : POLLIN;
+	}
+}
+
+bool SocketPoller::wait(sf::Time timeout)
+{
+	for (int i = 0; i < entries.size(); i++)
+	{
+		entries[i].returnedEvents = 0;
+	}
+
+	int timeoutMs = int(timeout.asMilliseconds());
+#ifdef _WIN32
+	int ready = WSAPoll(reinterpret_cast<PollEntry*>(entries.data()), ULONG(entries.size()), timeoutMs);
+#else
+	int ready = poll(reinterpret_cast<PollEntry*>(entries.data()), nfds_t(entries.size()), timeoutMs);
+#endif
+	return ready > 0;
+}
+
+bool SocketPoller::isReady(sf::Socket& socket)
+{
+	// A socket that has been disconnected or has an error is ready too, so that receiving from it finds out.
+	Entry* entry = find(socket);
+	return entry && (entry->returnedEvents & (POLLIN | POLLHUP | POLLERR)) != 0;
+}
+
+bool SocketPoller::isWritable(sf::Socket& socket)
+{
+	Entry* entry = find(socket);
+	return entry && (entry->returnedEvents & (POLLOUT | POLLHUP | POLLERR)) != 0;
+}
+
+SocketPoller::Entry* SocketPoller::find(sf::Socket& socket)
+{
+	std::unordered_map<sf::SocketHandle, std::size_t>::iterator it = indices.find(SocketHandleAccess::get(socket));
+	if (it == indices.end())
+	{
+		return nullptr;
+	}
+	return &entries[it->second];
+}
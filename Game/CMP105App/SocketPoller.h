@@ -0,0 +1,52 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <vector>
+#include <unordered_map>
+
+// Socket poller class. Waits until any of a set of sockets is ready, in the same way as sf::SocketSelector, but with poll() (WSAPoll() on Windows) rather than select().
+// select() can only watch FD_SETSIZE sockets, which is 64 on Windows, and sf::SocketSelector stops adding sockets past that, so a server using it stops hearing from new players. poll() has no such limit.
+// Sockets can also be watched for being able to send, for servers that queue what they send on sockets that don't block.
+class SocketPoller
+{
+public:
+	SocketPoller();
+	~SocketPoller();
+
+	// Start and stop watching a socket for data arriving (or new connections, for a listener).
+	void add(sf::Socket& socket);
+	void remove(sf::Socket& socket);
+
+	// Also watch a socket for being able to send. Turned on while a socket has packets queued.
+	void setWatchWritable(sf::Socket& socket, bool watch);
+
+	// Wait until at least one socket is ready, or the timeout has passed. Returns whether any socket is ready.
+	bool wait(sf::Time timeout);
+
+	// Whether a socket had data waiting (or was disconnected), or could send, when the last wait finished.
+	// ----
+	bool isReady(sf::Socket& socket);
+	bool isWritable(sf::Socket& socket);
+	// ----
+
+	// Number of sockets being watched.
+	int getCount()
+	{
+		return int(entries.size());
+	};
+
+private:
+	// A socket being watched. Laid out the same as pollfd (WSAPOLLFD on Windows), so the entries can be passed straight to poll().
+	struct Entry
+	{
+		sf::SocketHandle handle;
+		short events;
+		short returnedEvents;
+	};
+
+	// The entry for a socket, or nullptr if it isn't being watched.
+	Entry* find(sf::Socket& socket);
+
+	// Entries, and where each socket's entry is. Removing a socket moves the last entry into its place.
+	std::vector<Entry> entries;
+	std::unordered_map<sf::SocketHandle, std::size_t> indices;
+};
@@ -0,0 +1,107 @@
+#include "SpatialGrid.h"
+
+SpatialGrid::SpatialGrid(sf::Vector2f size, float c)
+{
+	cellSize = c;
+	columns = std::max(1, int(std::ceil(size.x / cellSize)));
+	rows = std::max(1, int(std::ceil(size.y / cellSize)));
+	cellStart.resize(columns * rows + 1);
+}
+
+SpatialGrid::~SpatialGrid()
+{
+}
+
+int SpatialGrid::cellX(float x)
+{
+	return std::min(std::max(int(x / cellSize), 0), columns - 1);
+}
+
+int SpatialGrid::cellY(float y)
+{
+	return std::min(std::max(int(y / cellSize), 0), rows - 1);
+}
+
+void SpatialGrid::build(PhysicsWorld& world, int first, int count)
+{
+	// Work out the cells each body covers (left, top, right, bottom), and count the bodies in each cell.
+	bodyCells.resize(count * 4);
+	std::fill(cellStart.begin(), cellStart.end(), 0);
+
+	for (int i = 0; i < count; i++)
+	{
+		sf::FloatRect box = world.getBox(first + i);
+		int* cells = &bodyCells[i * 4];
+		cells[0] = cellX(box.left);
+		cells[1] = cellY(box.top);
+		cells[2] = cellX(box.left + box.width);
+		cells[3] = cellY(box.top + box.height);
+
+		for (int y = cells[1]; y <= cells[3]; y++)
+		{
+			for (int x = cells[0]; x <= cells[2]; x++)
+			{
+				cellStart[y * columns + x + 1]++;
+			}
+		}
+	}
+
+	// Turn the counts into where each cell starts.
+	for (int c = 0; c < columns * rows; c++)
+	{
+		cellStart[c + 1] += cellStart[c];
+	}
+
+	// Fill in the cells. Each cell's start is moved along as it fills, then moved back afterwards.
+	cellBodies.resize(cellStart[columns * rows]);
+	for (int i = 0; i < count; i++)
+	{
+		int* cells = &bodyCells[i * 4];
+		for (int y = cells[1]; y <= cells[3]; y++)
+		{
+			for (int x = cells[0]; x <= cells[2]; x++)
+			{
+				cellBodies[cellStart[y * columns + x]++] = first + i;
+			}
+		}
+	}
+
+	for (int c = columns * rows; c > 0; c--)
+	{
+		cellStart[c] = cellStart[c - 1];
+	}
+	cellStart[0] = 0;
+}
+
+void SpatialGrid::findPairs(PhysicsWorld& world, std::vector<std::pair<int, int>>& pairs)
+{
+	for (int y = 0; y < rows; y++)
+	{
+		for (int x = 0; x < columns; x++)
+		{
+			int c = y * columns + x;
+			for (int i = cellStart[c]; i < cellStart[c + 1]; i++)
+			{
+				for (int j = i + 1; j < cellStart[c + 1]; j++)
+				{
+					int a = cellBodies[i];
+					int b = cellBodies[j];
+					if (!world.overlaps(a, b))
+					{
+						continue;
+					}
+
+					// Only the cell holding the top left corner of the overlap reports the pair.
+					sf::FloatRect boxA = world.getBox(a);
+					sf::FloatRect boxB = world.getBox(b);
+					if (cellX(std::max(boxA.left, boxB.left)) != x || cellY(std::max(boxA.top, boxB.top)) != y)
+					{
+						continue;
+					}
+
+					pairs.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <algorithm>
+#include "PhysicsWorld.h"
+
+// Spatial grid class. A uniform grid broadphase over the arena, for finding which moving bodies (players and balls) might be touching without testing every pair.
+// Each body is put in every cell its box covers. The cells are stored one after the other in a single array, built with a counting sort, so rebuilding every step doesn't allocate once the arrays have grown.
+// Pairs are then found in one sweep over the cells. A pair that shares several cells is only reported by the cell holding the top left corner of where the boxes overlap, so each pair is found once.
+class SpatialGrid
+{
+public:
+	// The grid covers an area of the given size, split into square cells. Bodies outside the area are put in the nearest cells.
+	SpatialGrid(sf::Vector2f size, float cellSize);
+	~SpatialGrid();
+
+	// Put bodies first to first + count - 1 of the world into the grid, replacing whatever was in it.
+	void build(PhysicsWorld& world, int first, int count);
+
+	// Find every pair of bodies in the grid whose boxes overlap, lower body first. Pairs are added to the end of the vector.
+	void findPairs(PhysicsWorld& world, std::vector<std::pair<int, int>>& pairs);
+
+	// Getter functions.
+	// ----
+	int getColumns()
+	{
+		return columns;
+	};
+
+	int getRows()
+	{
+		return rows;
+	};
+	// ----
+
+private:
+	// Cell a point is in, clamped to the grid.
+	int cellX(float x);
+	int cellY(float y);
+
+	// Size of the grid.
+	float cellSize;
+	int columns;
+	int rows;
+
+	// Bodies in each cell. The bodies in cell c are cellBodies[cellStart[c]] to cellBodies[cellStart[c + 1] - 1].
+	std::vector<int> cellStart;
+	std::vector<int> cellBodies;
+
+	// Range of cells each body covers, saved while counting so it isn't worked out twice.
+	std::vector<int> bodyCells;
+};
@@ -0,0 +1,77 @@
+#include "SpriteBatch.h"
+
+SpriteBatch::SpriteBatch()
+{
+	vertices.setPrimitiveType(sf::Quads);
+	drawCalls = 0;
+}
+
+SpriteBatch::~SpriteBatch()
+{
+}
+
+void SpriteBatch::clear()
+{
+	// Keeps the memory, so adding the same shapes next frame doesn't allocate.
+	vertices.clear();
+	batches.clear();
+}
+
+void SpriteBatch::add(const sf::Shape& shape)
+{
+	// Only four sided shapes can be drawn as a quad.
+	if (shape.getPointCount() != 4)
+	{
+		return;
+	}
+
+	// Start a new batch if the texture is different to the last shape's.
+	const sf::Texture* texture = shape.getTexture();
+	if (batches.empty() || batches.back().texture != texture)
+	{
+		Batch batch;
+		batch.texture = texture;
+		batch.first = vertices.getVertexCount();
+		batch.count = 0;
+		batches.push_back(batch);
+	}
+
+	// Bounds of the fill, not counting any outline.
+	sf::Vector2f corners[4];
+	sf::Vector2f low = shape.getPoint(0);
+	sf::Vector2f high = low;
+	for (std::size_t i = 0; i < 4; i++)
+	{
+		corners[i] = shape.getPoint(i);
+		low = sf::Vector2f(std::min(low.x, corners[i].x), std::min(low.y, corners[i].y));
+		high = sf::Vector2f(std::max(high.x, corners[i].x), std::max(high.y, corners[i].y));
+	}
+
+	// Transform each corner into world space, and map it onto the texture rectangle in the same way as sf::Shape does.
+	sf::Transform transform = shape.getTransform();
+	sf::IntRect textureRect = shape.getTextureRect();
+	sf::Color colour = shape.getFillColor();
+
+	for (std::size_t i = 0; i < 4; i++)
+	{
+		sf::Vector2f point = corners[i];
+		float u = high.x > low.x ? (point.x - low.x) / (high.x - low.x) : 0;
+		float v = high.y > low.y ? (point.y - low.y) / (high.y - low.y) : 0;
+		sf::Vector2f texCoords(textureRect.left + textureRect.width * u, textureRect.top + textureRect.height * v);
+		vertices.append(sf::Vertex(transform.transformPoint(point), colour, texCoords));
+	}
+
+	batches.back().count += 4;
+}
+
+void SpriteBatch::draw(sf::RenderTarget& target)
+{
+	drawCalls = 0;
+	for (int i = 0; i < batches.size(); i++)
+	{
+		sf::RenderStates states;
+		states.texture = batches[i].texture;
+		target.draw(&vertices[batches[i].first], batches[i].count, sf::Quads, states);
+		drawCalls++;
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <algorithm>
+
+// Sprite batch class. Collects rectangle shapes (such as game objects) into one vertex array, then draws each run of shapes that share a texture with a single draw call, rather than one draw call and texture bind for every object.
+// Shapes are drawn in the order they are added, so overlapping objects still appear in the right order. Adding shapes that share a texture one after the other keeps the number of draw calls down.
+// Only the fill is drawn. Outlines, such as on collision box debug shapes, need drawing as normal.
+class SpriteBatch
+{
+public:
+	SpriteBatch();
+	~SpriteBatch();
+
+	// Remove every shape, ready to collect the next frame.
+	void clear();
+
+	// Add a shape's fill, using its transform, texture, texture rectangle and fill colour.
+	void add(const sf::Shape& shape);
+
+	// Draw everything added since the last clear.
+	void draw(sf::RenderTarget& target);
+
+	// Number of draw calls made by the last call to draw().
+	int getDrawCalls()
+	{
+		return drawCalls;
+	};
+
+private:
+	// A run of quads that share a texture, drawn with one draw call.
+	struct Batch
+	{
+		const sf::Texture* texture;
+		std::size_t first;
+		std::size_t count;
+	};
+
+	sf::VertexArray vertices;
+	std::vector<Batch> batches;
+	int drawCalls;
+};
@@ -0,0 +1,175 @@
+#include "TextureAtlas.h"
+
+const std::vector<std::string> TextureAtlas::matchSprites = { "football", "goalposts", "messi", "ronaldo", "kirby", "miedema" };
+const std::string TextureAtlas::imageFile = "gfx/atlas.png";
+const std::string TextureAtlas::indexFile = "gfx/atlas.txt";
+
+TextureAtlas::TextureAtlas()
+{
+	maxSize = int(sf::Texture::getMaximumSize());
+	padding = 2;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+}
+
+bool TextureAtlas::load(const std::vector<std::string>& names)
+{
+	return loadImage(names) && upload();
+}
+
+bool TextureAtlas::loadImage(const std::vector<std::string>& names)
+{
+	// Use the saved atlas if it has every sprite.
+	bool saved = loadIndex() && AssetArchive::getShared().loadImage(image, imageFile) && regions.count("white") > 0;
+	for (int i = 0; saved && i < names.size(); i++)
+	{
+		saved = regions.count(names[i]) > 0;
+	}
+
+	if (!saved)
+	{
+		std::cout << "Packing texture atlas. Run with -pack-atlas to save it.\n";
+		return pack(names);
+	}
+
+	return true;
+}
+
+bool TextureAtlas::upload()
+{
+	// The image isn't needed once it is on the GPU.
+	bool uploaded = texture.loadFromImage(image);
+	image = sf::Image();
+	return uploaded;
+}
+
+bool TextureAtlas::packAndSave(const std::vector<std::string>& names)
+{
+	if (!pack(names) || !image.saveToFile(imageFile) || !saveIndex())
+	{
+		std::cout << "Could not save texture atlas.\n";
+		return false;
+	}
+
+	std::cout << "Packed " << names.size() << " sprites into " << image.getSize().x << "x" << image.getSize().y << " atlas " << imageFile << ".\n";
+	return true;
+}
+
+bool TextureAtlas::pack(const std::vector<std::string>& names)
+{
+	regions.clear();
+
+	// Load every sprite, and add a white square at the end for drawing plain coloured shapes.
+	std::vector<std::string> spriteNames = names;
+	spriteNames.push_back("white");
+	std::vector<sf::Image> sprites(spriteNames.size());
+	for (int i = 0; i < names.size(); i++)
+	{
+		if (!AssetArchive::getShared().loadImage(sprites[i], "gfx/" + names[i] + ".png"))
+		{
+			return false;
+		}
+	}
+	sprites.back().create(4, 4, sf::Color::White);
+
+	// Shelf packing: place sprites tallest first along a row (shelf), starting a new shelf below when the row is full. Sorting by height keeps the space wasted above shorter sprites small.
+	std::vector<int> order(spriteNames.size());
+	for (int i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&sprites](int a, int b) { return sprites[a].getSize().y > sprites[b].getSize().y; });
+
+	int x = 0;
+	int y = 0;
+	int shelfHeight = 0;
+	int width = 0;
+
+	for (int i = 0; i < order.size(); i++)
+	{
+		sf::Vector2u size = sprites[order[i]].getSize();
+		int w = int(size.x) + padding * 2;
+		int h = int(size.y) + padding * 2;
+
+		if (x + w > maxSize)
+		{
+			x = 0;
+			y += shelfHeight;
+			shelfHeight = 0;
+		}
+		if (x + w > maxSize || y + h > maxSize)
+		{
+			std::cout << "Sprites don't fit in a " << maxSize << "x" << maxSize << " texture atlas.\n";
+			return false;
+		}
+
+		regions[spriteNames[order[i]]] = sf::IntRect(x + padding, y + padding, size.x, size.y);
+		x += w;
+		width = std::max(width, x);
+		shelfHeight = std::max(shelfHeight, h);
+	}
+
+	// Copy the sprites into place.
+	image.create(width, y + shelfHeight, sf::Color::Transparent);
+	for (int i = 0; i < spriteNames.size(); i++)
+	{
+		sf::IntRect region = regions[spriteNames[i]];
+		image.copy(sprites[i], region.left, region.top);
+	}
+
+	// Only the middle of the white square is used, so smoothing never samples the transparent gap around it.
+	sf::IntRect white = regions["white"];
+	regions["white"] = sf::IntRect(white.left + 1, white.top + 1, white.width - 2, white.height - 2);
+
+	return true;
+}
+
+bool TextureAtlas::loadIndex()
+{
+	std::string text;
+	if (!AssetArchive::getShared().loadText(text, indexFile))
+	{
+		return false;
+	}
+	std::istringstream file(text);
+
+	// Each line is: name, left, top, width, height. Blank lines and lines starting with # are skipped, the same as level descriptions.
+	regions.clear();
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream stream(line);
+		std::string name;
+		sf::IntRect region;
+		if (!(stream >> name) || name[0] == '#')
+		{
+			continue;
+		}
+		if (stream >> region.left >> region.top >> region.width >> region.height)
+		{
+			regions[name] = region;
+		}
+	}
+
+	return true;
+}
+
+bool TextureAtlas::saveIndex()
+{
+	std::ofstream file(indexFile);
+	if (!file)
+	{
+		return false;
+	}
+
+	file << "# Regions of each sprite in " << imageFile << ", in pixels. Written by -pack-atlas.\n";
+	file << "# name left top width height\n";
+	for (std::map<std::string, sf::IntRect>::iterator it = regions.begin(); it != regions.end(); it++)
+	{
+		file << it->first << " " << it->second.left << " " << it->second.top << " " << it->second.width << " " << it->second.height << "\n";
+	}
+
+	return true;
+}
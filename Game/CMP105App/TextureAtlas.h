@@ -0,0 +1,67 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include "AssetArchive.h"
+
+// Texture atlas class. Holds many sprites packed into one texture, and the rectangle (region) of each one, so objects using different sprites can be drawn together in one draw call by the sprite batch.
+// The atlas is packed ahead of time (by running with "-pack-atlas") and saved as an image and an index of regions. If the saved atlas is missing, or doesn't have every sprite, the sprites are packed when the game loads instead.
+class TextureAtlas
+{
+public:
+	TextureAtlas();
+	~TextureAtlas();
+
+	// Load the saved atlas, or pack the named sprites (file names in gfx without .png) if it is missing or doesn't have all of them. Returns false if the atlas couldn't be made.
+	bool load(const std::vector<std::string>& names);
+
+	// The two halves of load(), so the atlas can be loaded in the background. Making the image only uses the CPU, so it can run on any thread. Uploading it to the texture has to be done on the main thread.
+	bool loadImage(const std::vector<std::string>& names);
+	bool upload();
+
+	// Pack the named sprites and save the atlas image and index. Returns false if a sprite couldn't be loaded or the atlas couldn't be saved.
+	bool packAndSave(const std::vector<std::string>& names);
+
+	// Getter functions.
+	// ----
+	sf::Texture* getTexture()
+	{
+		return &texture;
+	};
+
+	// Region of a sprite in the atlas. Empty if the sprite isn't in it. The "white" region is plain white, so shapes using it are drawn in their fill colour.
+	sf::IntRect getRegion(std::string name)
+	{
+		std::map<std::string, sf::IntRect>::iterator it = regions.find(name);
+		return it != regions.end() ? it->second : sf::IntRect();
+	};
+	// ----
+
+	// Sprites used by the match, and where the atlas is saved.
+	static const std::vector<std::string> matchSprites;
+	static const std::string imageFile;
+	static const std::string indexFile;
+
+private:
+	// Pack sprites into image, filling in regions. Returns false if a sprite couldn't be loaded or they don't fit in the largest texture allowed.
+	bool pack(const std::vector<std::string>& names);
+
+	// Read and write the index of regions.
+	bool loadIndex();
+	bool saveIndex();
+
+	sf::Image image;
+	sf::Texture texture;
+	std::map<std::string, sf::IntRect> regions;
+
+	// Largest texture the GPU allows. Found when the atlas is created, as it needs OpenGL.
+	int maxSize;
+
+	// Gap left around each sprite, so smoothing doesn't bleed neighbouring sprites into each other's edges.
+	int padding;
+};